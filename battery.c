@@ -0,0 +1,142 @@
+#include <string.h>
+
+#include <psp2/power.h>
+#include <psp2/kernel/processmgr.h>
+#include <psp2/kernel/threadmgr.h>
+
+#include "battery.h"
+#include "sysinfo.h"
+
+#define DRAIN_MIN_SPAN_MS 60000	// capacity moves in whole mAh, give it a minute
+
+static BatterySample ring[BATTERY_RING_SIZE];
+static int ring_head = 0;	// next slot to write
+static int ring_count = 0;
+static BatteryTickStats tick_stats;
+
+static SceUID mutex = -1;
+static SceUID thread = -1;
+static volatile int running = 0;
+static int interval = 1000000;
+
+static void sample(BatterySample *s) {
+	s->time_ms = sceKernelGetProcessTimeWide() / 1000;
+	s->percent = scePowerGetBatteryLifePercent();
+	s->temp = scePowerGetBatteryTemp();
+	s->voltage = scePowerGetBatteryVolt();
+	s->remaining = scePowerGetBatteryRemainCapacity();
+}
+
+static int samplerThread(SceSize args, void *argp) {
+	BatterySample s;
+	SceInt64 start;
+	unsigned cost;
+
+	while (running) {
+		start = sceKernelGetProcessTimeWide();
+		sample(&s);
+
+		sceKernelLockMutex(mutex, 1, NULL);
+		ring[ring_head] = s;
+		ring_head = (ring_head + 1) % BATTERY_RING_SIZE;
+		if (ring_count < BATTERY_RING_SIZE)
+			ring_count++;
+
+		cost = sceKernelGetProcessTimeWide() - start;
+		tick_stats.ticks++;
+		tick_stats.last_us = cost;
+		tick_stats.total_us += cost;
+		if (cost > tick_stats.max_us)
+			tick_stats.max_us = cost;
+		sceKernelUnlockMutex(mutex, 1);
+
+		sceKernelDelayThread(interval);
+	}
+	return 0;
+}
+
+int batteryStart(int interval_us) {
+	int ret;
+
+	if (running)
+		return 0;
+
+	interval = interval_us;
+	if (mutex < 0) {
+		mutex = sceKernelCreateMutex("battery_mutex", 0, 0, NULL);
+		if (mutex < 0)
+			return mutex;
+	}
+
+	thread = sceKernelCreateThread("battery_sampler", samplerThread, 0x10000100, 0x2000, 0, 0, NULL);
+	if (thread < 0)
+		return thread;
+
+	running = 1;
+	ret = sceKernelStartThread(thread, 0, NULL);
+	if (ret < 0) {
+		running = 0;
+		sceKernelDeleteThread(thread);
+		thread = -1;
+	}
+	return ret;
+}
+
+void batteryStop() {
+	if (!running)
+		return;
+
+	running = 0;
+	sceKernelWaitThreadEnd(thread, NULL, NULL);
+	sceKernelDeleteThread(thread);
+	thread = -1;
+}
+
+int batterySamples(BatterySample *out, int max) {
+	int i, count, first;
+
+	if (mutex < 0)
+		return 0;
+
+	sceKernelLockMutex(mutex, 1, NULL);
+	count = ring_count < max ? ring_count : max;
+	first = (ring_head - count + BATTERY_RING_SIZE) % BATTERY_RING_SIZE;
+	for (i = 0; i < count; i++)
+		out[i] = ring[(first + i) % BATTERY_RING_SIZE];
+	sceKernelUnlockMutex(mutex, 1);
+
+	return count;
+}
+
+void batteryTickStats(BatteryTickStats *stats) {
+	if (mutex < 0) {
+		memset(stats, 0, sizeof(*stats));
+		return;
+	}
+
+	sceKernelLockMutex(mutex, 1, NULL);
+	*stats = tick_stats;
+	sceKernelUnlockMutex(mutex, 1);
+}
+
+int batteryDrainRate(int *mah_per_hour) {
+	BatterySample first, last;
+	int span;
+
+	if (mutex < 0)
+		return -1;
+
+	sceKernelLockMutex(mutex, 1, NULL);
+	if (ring_count >= 2) {
+		first = ring[(ring_head - ring_count + BATTERY_RING_SIZE) % BATTERY_RING_SIZE];
+		last = ring[(ring_head - 1 + BATTERY_RING_SIZE) % BATTERY_RING_SIZE];
+	}
+	span = ring_count >= 2 ? (int)(last.time_ms - first.time_ms) : 0;
+	sceKernelUnlockMutex(mutex, 1);
+
+	if (span < DRAIN_MIN_SPAN_MS)
+		return -1;
+
+	*mah_per_hour = (first.remaining - last.remaining) * 3600000LL / span;
+	return 0;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <psp2/types.h>
+
+// Background battery sampler. One thread polls scePower at a fixed rate
+// into a ring allocated up front; readers take copies under a mutex.
+
+#define BATTERY_RING_SIZE 256
+
+// fixed point, so a sample is 12 bytes and needs no float formatting
+typedef struct {
+	SceUInt32 time_ms;		// process time
+	short percent;
+	short temp;				// 1/100 degree Celsius
+	short voltage;			// mV
+	short remaining;		// mAh
+} BatterySample;
+
+typedef struct {
+	unsigned ticks;
+	unsigned last_us;		// cost of the last tick
+	unsigned max_us;
+	SceUInt64 total_us;
+} BatteryTickStats;
+
+int batteryStart(int interval_us);
+void batteryStop();
+
+// the newest max samples, oldest first; returns how many were copied
+int batterySamples(BatterySample *out, int max);
+
+void batteryTickStats(BatteryTickStats *stats);
+
+// mAh used per hour over the samples so far, negative while charging;
+// returns < 0 until there is enough history
+int batteryDrainRate(int *mah_per_hour);
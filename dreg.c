@@ -0,0 +1,118 @@
+#include <string.h>
+
+#include "dreg.h"
+
+// keys whose place in system.dreg is known; extend as more are located
+// (host/dregdump helps comparing captures)
+const DregKey dreg_keys[] = {
+	{ "/CONFIG/SYSTEM", "region_no", 92, DREG_INT, 1 },
+};
+
+const int dreg_key_count = sizeof(dreg_keys) / sizeof(dreg_keys[0]);
+
+/********************* key index *********************************/
+
+#define INDEX_SIZE 64	// power of two, well over twice the table
+
+static signed char key_index[INDEX_SIZE];
+static int index_ready = 0;
+
+// FNV-1a over "category/name"
+static unsigned hashKey(const char *category, const char *name) {
+	unsigned hash = 2166136261u;
+
+	for (; *category; category++)
+		hash = (hash ^ (unsigned char)*category) * 16777619u;
+	hash = (hash ^ '/') * 16777619u;
+	for (; *name; name++)
+		hash = (hash ^ (unsigned char)*name) * 16777619u;
+	return hash;
+}
+
+static void buildIndex() {
+	unsigned slot;
+	int i;
+
+	memset(key_index, -1, sizeof(key_index));
+	for (i = 0; i < dreg_key_count; i++) {
+		slot = hashKey(dreg_keys[i].category, dreg_keys[i].name) & (INDEX_SIZE - 1);
+		while (key_index[slot] >= 0)
+			slot = (slot + 1) & (INDEX_SIZE - 1);
+		key_index[slot] = i;
+	}
+	index_ready = 1;
+}
+
+const DregKey* dregFind(const char *category, const char *name) {
+	unsigned slot;
+	const DregKey *key;
+
+	if (!index_ready)
+		buildIndex();
+
+	slot = hashKey(category, name) & (INDEX_SIZE - 1);
+	while (key_index[slot] >= 0) {
+		key = &dreg_keys[(int)key_index[slot]];
+		if (strcmp(key->name, name) == 0 && strcmp(key->category, category) == 0)
+			return key;
+		slot = (slot + 1) & (INDEX_SIZE - 1);
+	}
+	return NULL;
+}
+
+/********************* values *********************************/
+
+void dregInit(Dreg *dreg, const void *data, int size) {
+	dreg->data = data;
+	dreg->size = size;
+
+	if (!index_ready)
+		buildIndex();
+}
+
+static const DregKey* lookup(const Dreg *dreg, const char *category, const char *name, DregType type, int *ret) {
+	const DregKey *key = dregFind(category, name);
+
+	if (key == NULL) {
+		*ret = DREG_ERROR_NO_KEY;
+	} else if (key->type != type) {
+		*ret = DREG_ERROR_TYPE;
+	} else if (key->offset + key->size > dreg->size) {
+		*ret = DREG_ERROR_TRUNCATED;
+	} else {
+		*ret = 0;
+		return key;
+	}
+	return NULL;
+}
+
+int dregGetInt(const Dreg *dreg, const char *category, const char *name, int *val) {
+	const DregKey *key;
+	unsigned value = 0;
+	int i, ret;
+
+	key = lookup(dreg, category, name, DREG_INT, &ret);
+	if (key == NULL)
+		return ret;
+
+	for (i = key->size - 1; i >= 0; i--)
+		value = value << 8 | dreg->data[key->offset + i];
+	*val = value;
+	return 0;
+}
+
+int dregGetString(const Dreg *dreg, const char *category, const char *name, char *string, int size) {
+	const DregKey *key;
+	int len, ret;
+
+	key = lookup(dreg, category, name, DREG_STRING, &ret);
+	if (key == NULL)
+		return ret;
+
+	len = strnlen((const char *)dreg->data + key->offset, key->size);
+	if (len > size - 1)
+		len = size - 1;
+	memcpy(string, dreg->data + key->offset, len);
+	string[len] = '\0';
+	return 0;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+// vd0:registry/system.dreg decoder. The file holds the registry values with
+// no names; which key lives where comes from the descriptor table in dreg.c.
+// Works on a buffer read once, so it runs on captured files on the host too.
+
+#define DREG_PATH "vd0:registry/system.dreg"
+
+#define DREG_ERROR_NO_KEY    -1	// not in the descriptor table
+#define DREG_ERROR_TYPE      -2	// asked for an int, key holds a string or v.v.
+#define DREG_ERROR_TRUNCATED -3	// file too short for the key's offset
+
+typedef enum {
+	DREG_INT,		// little endian, 1 to 4 bytes
+	DREG_STRING,	// NUL padded to size
+	DREG_BINARY,
+} DregType;
+
+typedef struct {
+	const char *category;
+	const char *name;
+	int offset;
+	DregType type;
+	int size;
+} DregKey;
+
+typedef struct {
+	const unsigned char *data;
+	int size;
+} Dreg;
+
+extern const DregKey dreg_keys[];
+extern const int dreg_key_count;
+
+void dregInit(Dreg *dreg, const void *data, int size);
+
+// hashed lookup, NULL for keys the table doesn't know
+const DregKey* dregFind(const char *category, const char *name);
+
+int dregGetInt(const Dreg *dreg, const char *category, const char *name, int *val);
+int dregGetString(const Dreg *dreg, const char *category, const char *name, char *string, int size);
@@ -0,0 +1,238 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include <psp2/io/fcntl.h>
+#include <psp2/io/stat.h>
+
+#include "export.h"
+
+#define WRITER_BUFFER_SIZE 4096
+
+// buffered sceIoWrite, so a whole export is a handful of syscalls
+typedef struct {
+	SceUID fd;
+	int len;
+	int error;
+	char buf[WRITER_BUFFER_SIZE];
+} Writer;
+
+static Writer writer;
+
+static void writerFlush(Writer *w) {
+	int ret;
+
+	if (w->len > 0 && w->error >= 0) {
+		ret = sceIoWrite(w->fd, w->buf, w->len);
+		if (ret < 0)
+			w->error = ret;
+		else if (ret != w->len)
+			w->error = -1;
+	}
+	w->len = 0;
+}
+
+static void writerPut(Writer *w, const char *data, int size) {
+	int n;
+
+	while (size > 0) {
+		n = WRITER_BUFFER_SIZE - w->len;
+		if (n > size)
+			n = size;
+
+		memcpy(w->buf + w->len, data, n);
+		w->len += n;
+		data += n;
+		size -= n;
+
+		if (w->len == WRITER_BUFFER_SIZE)
+			writerFlush(w);
+	}
+}
+
+static void writerString(Writer *w, const char *string) {
+	writerPut(w, string, strlen(string));
+}
+
+static void writerChar(Writer *w, char c) {
+	writerPut(w, &c, 1);
+}
+
+static void writerPrintf(Writer *w, const char *format, ...) {
+	char line[128];
+	va_list opt;
+	int len;
+
+	va_start(opt, format);
+	len = vsnprintf(line, sizeof(line), format, opt);
+	va_end(opt);
+
+	if (len > (int)sizeof(line) - 1)
+		len = sizeof(line) - 1;
+	if (len > 0)
+		writerPut(w, line, len);
+}
+
+// output goes to path.tmp first; only a complete file replaces path
+static int writerOpen(Writer *w, const char *tmp_path) {
+	sceIoMkdir(EXPORT_DIR, 0777);
+
+	w->len = 0;
+	w->error = 0;
+	w->fd = sceIoOpen(tmp_path, SCE_O_WRONLY | SCE_O_CREAT | SCE_O_TRUNC, 0777);
+	return w->fd < 0 ? w->fd : 0;
+}
+
+static int writerCommit(Writer *w, const char *tmp_path, const char *path) {
+	int ret;
+
+	writerFlush(w);
+	ret = sceIoClose(w->fd);
+	if (w->error >= 0 && ret < 0)
+		w->error = ret;
+
+	if (w->error < 0) {
+		sceIoRemove(tmp_path);
+		return w->error;
+	}
+
+	//rename won't replace an existing file on the Vita
+	sceIoRemove(path);
+	return sceIoRename(tmp_path, path);
+}
+
+/********************* field helpers *********************************/
+
+// labels are written without the colon they have on screen
+static int labelLength(const char *label) {
+	int len = strlen(label);
+
+	if (len > 0 && label[len - 1] == ':')
+		len--;
+	return len;
+}
+
+static const char *fieldLabel(SystemSnapshot *snap, const ProbeDesc *probe) {
+	const char *label = snap->fields[probe->id].label;
+
+	return label ? label : probe->label;
+}
+
+static int exported(SystemSnapshot *snap, const ProbeDesc *probe) {
+	//a pending field is still being written by a background collect
+	return !snap->fields[probe->id].pending && snap->fields[probe->id].collected &&
+		probeVisible(snap, probe);
+}
+
+/********************* JSON *********************************/
+
+static void jsonString(Writer *w, const char *string, int len) {
+	int i;
+	unsigned char c;
+
+	writerChar(w, '"');
+	for (i = 0; i < len; i++) {
+		c = string[i];
+		if (c == '"' || c == '\\') {
+			writerChar(w, '\\');
+			writerChar(w, c);
+		} else if (c < 0x20) {
+			writerPrintf(w, "\\u%04x", c);
+		} else {
+			writerChar(w, c);
+		}
+	}
+	writerChar(w, '"');
+}
+
+int exportJson(SystemSnapshot *snap, const char *path) {
+	Writer *w = &writer;
+	char tmp_path[128];
+	int i, first = 1, ret;
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+	ret = writerOpen(w, tmp_path);
+	if (ret < 0)
+		return ret;
+
+	writerString(w, "{\n\t\"tool\": \"PSVident\",\n\t\"version\": \"" PSVIDENT_VERSION "\",\n");
+	writerPrintf(w, "\t\"passes\": %u,\n\t\"collect_us\": %lld,\n\t\"fields\": [", snap->passes, snap->collect_us);
+
+	for (i = 0; i < probe_count; i++) {
+		const ProbeDesc *probe = &probe_table[i];
+		FieldValue *value = &snap->fields[probe->id];
+		const char *label = fieldLabel(snap, probe);
+
+		if (!exported(snap, probe))
+			continue;
+
+		writerString(w, first ? "\n\t\t{ \"key\": " : ",\n\t\t{ \"key\": ");
+		jsonString(w, field_keys[probe->id], strlen(field_keys[probe->id]));
+		writerString(w, ", \"category\": ");
+		jsonString(w, category_keys[probe->category], strlen(category_keys[probe->category]));
+		writerString(w, ", \"label\": ");
+		jsonString(w, label, labelLength(label));
+		writerString(w, ", \"value\": ");
+		jsonString(w, value->text, strlen(value->text));
+		writerPrintf(w, ", \"error\": %d }", value->error);
+		first = 0;
+	}
+
+	writerString(w, "\n\t]\n}\n");
+	return writerCommit(w, tmp_path, path);
+}
+
+/********************* CSV *********************************/
+
+static void csvString(Writer *w, const char *string, int len) {
+	int i;
+
+	writerChar(w, '"');
+	for (i = 0; i < len; i++) {
+		if (string[i] == '"')
+			writerChar(w, '"');
+		writerChar(w, string[i]);
+	}
+	writerChar(w, '"');
+}
+
+int exportCsv(SystemSnapshot *snap, const char *path) {
+	Writer *w = &writer;
+	char tmp_path[128];
+	int i, ret;
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+	ret = writerOpen(w, tmp_path);
+	if (ret < 0)
+		return ret;
+
+	writerString(w, "key,category,label,value,error\n");
+
+	for (i = 0; i < probe_count; i++) {
+		const ProbeDesc *probe = &probe_table[i];
+		FieldValue *value = &snap->fields[probe->id];
+		const char *label = fieldLabel(snap, probe);
+
+		if (!exported(snap, probe))
+			continue;
+
+		writerString(w, field_keys[probe->id]);
+		writerChar(w, ',');
+		writerString(w, category_keys[probe->category]);
+		writerChar(w, ',');
+		csvString(w, label, labelLength(label));
+		writerChar(w, ',');
+		csvString(w, value->text, strlen(value->text));
+		writerPrintf(w, ",%d\n", value->error);
+	}
+
+	return writerCommit(w, tmp_path, path);
+}
+
+int exportReport(SystemSnapshot *snap) {
+	int ret = exportJson(snap, EXPORT_JSON_PATH);
+
+	if (ret < 0)
+		return ret;
+	return exportCsv(snap, EXPORT_CSV_PATH);
+}
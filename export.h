@@ -0,0 +1,17 @@
+#pragma once
+
+#include "snapshot.h"
+
+// Machine-readable copies of the report for inventorying many units.
+// Streams through a fixed buffer, nothing is allocated.
+
+#define EXPORT_DIR "ux0:data/PSVident"
+#define EXPORT_JSON_PATH EXPORT_DIR "/report.json"
+#define EXPORT_CSV_PATH EXPORT_DIR "/report.csv"
+
+// writes every collected field to both files; returns < 0 on the first
+// error, leaving the previous export of that file in place
+int exportReport(SystemSnapshot *snap);
+
+int exportJson(SystemSnapshot *snap, const char *path);
+int exportCsv(SystemSnapshot *snap, const char *path);
@@ -0,0 +1,101 @@
+#include "fill.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FILL_NEON 1
+#endif
+
+// 64 bit view of the framebuffer for the portable path
+typedef uint64_t __attribute__((__may_alias__)) u64_alias;
+
+void psvFillSpan(Color *dst, int count, Color color)
+{
+	// align to 16 bytes so the wide stores below are aligned
+	while (count > 0 && ((uintptr_t)dst & 15)) {
+		*dst++ = color;
+		count--;
+	}
+
+#ifdef FILL_NEON
+	uint32x4_t v = vdupq_n_u32(color);
+	while (count >= 16) {
+		vst1q_u32(dst, v);
+		vst1q_u32(dst + 4, v);
+		vst1q_u32(dst + 8, v);
+		vst1q_u32(dst + 12, v);
+		dst += 16;
+		count -= 16;
+	}
+	while (count >= 4) {
+		vst1q_u32(dst, v);
+		dst += 4;
+		count -= 4;
+	}
+#else
+	uint64_t v = ((uint64_t)color << 32) | color;
+	u64_alias *wide = (u64_alias *)dst;
+	while (count >= 16) {
+		wide[0] = v; wide[1] = v; wide[2] = v; wide[3] = v;
+		wide[4] = v; wide[5] = v; wide[6] = v; wide[7] = v;
+		wide += 8;
+		count -= 16;
+	}
+	while (count >= 2) {
+		*wide++ = v;
+		count -= 2;
+	}
+	dst = (Color *)wide;
+#endif
+
+	while (count-- > 0)
+		*dst++ = color;
+}
+
+void psvFillRect(Color *base, int pitch, int x, int y, int w, int h, Color color)
+{
+	Color *row = base + y * pitch + x;
+
+	if (w <= 0 || h <= 0)
+		return;
+
+	// full width rectangles are one contiguous span
+	if (w == pitch) {
+		psvFillSpan(row, w * h, color);
+		return;
+	}
+
+	while (h-- > 0) {
+		psvFillSpan(row, w, color);
+		row += pitch;
+	}
+}
+
+void psvFillRows(Color *base, int pitch, int width, int y, int rows, Color color)
+{
+	psvFillRect(base, pitch, 0, y, width, rows, color);
+}
+
+void psvFillMoveRows(Color *base, int pitch, int width, int dst_y, int src_y, int rows)
+{
+	if (rows <= 0 || dst_y == src_y)
+		return;
+
+	// rows are contiguous when the surface spans the whole pitch
+	if (width == pitch) {
+		memmove(base + dst_y * pitch, base + src_y * pitch, rows * pitch * sizeof(Color));
+		return;
+	}
+
+	if (dst_y < src_y) {
+		int i;
+		for (i = 0; i < rows; i++)
+			memmove(base + (dst_y + i) * pitch, base + (src_y + i) * pitch, width * sizeof(Color));
+	} else {
+		int i;
+		for (i = rows - 1; i >= 0; i--)
+			memmove(base + (dst_y + i) * pitch, base + (src_y + i) * pitch, width * sizeof(Color));
+	}
+}
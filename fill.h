@@ -0,0 +1,17 @@
+#pragma once
+
+#include "graphics.h"
+
+// solid fills over 32 bit pixels, NEON on ARM and 64 bit stores elsewhere
+
+// fills count pixels starting at dst
+void psvFillSpan(Color *dst, int count, Color color);
+
+// fills a w*h rectangle, pitch is in pixels
+void psvFillRect(Color *base, int pitch, int x, int y, int w, int h, Color color);
+
+// fills whole rows [y, y + rows) of a width pixel wide surface
+void psvFillRows(Color *base, int pitch, int width, int y, int rows, Color color);
+
+// copies rows [src_y, src_y + rows) to dst_y, the ranges may overlap
+void psvFillMoveRows(Color *base, int pitch, int width, int dst_y, int src_y, int rows);
@@ -0,0 +1,128 @@
+#include "fmt.h"
+
+static const char hex_digits[] = "0123456789ABCDEF";
+
+int fmtUint(char *out, unsigned value) {
+	char digits[10];
+	int len = 0, i;
+
+	do {
+		digits[len++] = '0' + value % 10;
+		value /= 10;
+	} while (value);
+
+	for (i = 0; i < len; i++)
+		out[i] = digits[len - 1 - i];
+	out[len] = '\0';
+	return len;
+}
+
+int fmtInt(char *out, int value) {
+	if (value < 0) {
+		*out = '-';
+		return 1 + fmtUint(out + 1, 0u - (unsigned)value);
+	}
+	return fmtUint(out, value);
+}
+
+int fmtFixed(char *out, int value, int scale, int decimals) {
+	unsigned magnitude, unit = 1, div = 1, whole, frac;
+	int len = 0, i;
+
+	if (value < 0) {
+		out[len++] = '-';
+		magnitude = 0u - (unsigned)value;
+	} else {
+		magnitude = value;
+	}
+
+	//drop the digits past decimals, rounding once
+	for (i = decimals; i < scale; i++)
+		div *= 10;
+	magnitude = magnitude / div + (magnitude % div >= (div + 1) / 2 && div > 1);
+	for (i = 0; i < decimals; i++)
+		unit *= 10;
+	for (i = scale; i < decimals; i++)
+		magnitude *= 10;
+
+	whole = magnitude / unit;
+	frac = magnitude % unit;
+
+	//"-0.00" reads wrong
+	if (len && whole == 0 && frac == 0)
+		len = 0;
+
+	len += fmtUint(out + len, whole);
+	if (decimals > 0) {
+		out[len++] = '.';
+		for (i = decimals - 1; i >= 0; i--) {
+			out[len + i] = '0' + frac % 10;
+			frac /= 10;
+		}
+		len += decimals;
+		out[len] = '\0';
+	}
+	return len;
+}
+
+int fmtHexBytes(char *out, const unsigned char *bytes, int count) {
+	int i;
+
+	for (i = 0; i < count; i++) {
+		out[i * 2] = hex_digits[bytes[i] >> 4];
+		out[i * 2 + 1] = hex_digits[bytes[i] & 0xF];
+	}
+	out[count * 2] = '\0';
+	return count * 2;
+}
+
+int fmtMac(char *out, const unsigned char mac[6]) {
+	int i;
+
+	for (i = 0; i < 6; i++) {
+		out[i * 3] = hex_digits[mac[i] >> 4];
+		out[i * 3 + 1] = hex_digits[mac[i] & 0xF];
+		out[i * 3 + 2] = ':';
+	}
+	out[17] = '\0';
+	return 17;
+}
+
+int fmtSize(char *out, uint64_t size) {
+	static const char *units[] = { "B", "KB", "MB", "GB", "TB", "PB", "EB" };
+	unsigned whole, frac;
+	uint64_t rem;
+	int i = 0, len, bits;
+	const char *unit;
+
+	while (i < 6 && size >> (10 * (i + 1)))
+		i++;
+
+	if (i == 0) {
+		len = fmtUint(out, (unsigned)size);
+	} else {
+		//hundredths from the remainder, kept to 50 bits so * 100 fits
+		bits = 10 * i;
+		whole = size >> bits;
+		rem = size & (((uint64_t)1 << bits) - 1);
+		if (bits > 50) {
+			rem >>= bits - 50;
+			bits = 50;
+		}
+		frac = (rem * 100 + ((uint64_t)1 << (bits - 1))) >> bits;
+		if (frac == 100) {
+			whole++;
+			frac = 0;
+		}
+		len = fmtUint(out, whole);
+		out[len++] = '.';
+		out[len++] = '0' + frac / 10;
+		out[len++] = '0' + frac % 10;
+	}
+
+	out[len++] = ' ';
+	for (unit = units[i]; *unit; unit++)
+		out[len++] = *unit;
+	out[len] = '\0';
+	return len;
+}
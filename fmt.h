@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+
+// Number formatting without printf. Every function writes a NUL-terminated
+// string into out and returns its length; out must be big enough (the
+// worst case is noted per function).
+
+int fmtUint(char *out, unsigned value);		// 11 bytes
+int fmtInt(char *out, int value);			// 12 bytes
+
+// value is in units of 10^-scale, printed with decimals digits after the
+// point, rounded half away from zero: fmtFixed(out, 4123, 3, 2) is "4.12"
+int fmtFixed(char *out, int value, int scale, int decimals);	// 24 bytes
+
+// uppercase hex, two digits per byte, no separators
+int fmtHexBytes(char *out, const unsigned char *bytes, int count);	// 2 * count + 1
+
+// "D4:4B:5E:..."
+int fmtMac(char *out, const unsigned char mac[6]);	// 18 bytes
+
+// "512 B", "1.50 KB", "29.71 GB"; as getSizeString used to print, except
+// that exact halves round up
+int fmtSize(char *out, uint64_t size);		// 16 bytes
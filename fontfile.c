@@ -0,0 +1,135 @@
+#include "fontfile.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __vita__
+#include <psp2/io/fcntl.h>
+#define fontOpen(path)                  sceIoOpen(path, SCE_O_RDONLY, 0)
+#define fontRead(fd, buf, size, offset) sceIoPread(fd, buf, size, offset)
+#define fontClose(fd)                   sceIoClose(fd)
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#define fontOpen(path)                  open(path, O_RDONLY)
+#define fontRead(fd, buf, size, offset) pread(fd, buf, size, offset)
+#define fontClose(fd)                   close(fd)
+#endif
+
+static int g_fd = -1;
+static uint16_t *g_codepoints;	// the index, the bitmaps stay on disk
+static unsigned g_count;
+static unsigned g_bitmap_offset;
+
+void psvFontFileClose()
+{
+	if (g_fd >= 0)
+		fontClose(g_fd);
+	g_fd = -1;
+	free(g_codepoints);
+	g_codepoints = NULL;
+	g_count = 0;
+}
+
+int psvFontFileOpen(const char *path)
+{
+	u8 header[PSV_FONT_HEADER_SIZE];
+	u8 *index;
+	unsigned i;
+	int fd;
+
+	psvFontFileClose();
+
+	fd = fontOpen(path);
+	if (fd < 0)
+		return fd;
+
+	if (fontRead(fd, header, sizeof(header), 0) != sizeof(header) ||
+			memcmp(header, PSV_FONT_MAGIC, 4) != 0 ||
+			(header[4] | header[5] << 8) != PSV_FONT_VERSION ||
+			header[6] != 8 || header[7] != 8) {
+		fontClose(fd);
+		return -1;
+	}
+
+	g_count = header[8] | header[9] << 8 | header[10] << 16 | (unsigned)header[11] << 24;
+	if (g_count > 0x10000) {
+		fontClose(fd);
+		return -1;
+	}
+
+	// read as bytes and converted in place, the file is little endian
+	index = malloc(g_count * 2 + 1);
+	if (index == NULL ||
+			fontRead(fd, index, g_count * 2, PSV_FONT_HEADER_SIZE) != (int)(g_count * 2)) {
+		free(index);
+		fontClose(fd);
+		return -1;
+	}
+	g_codepoints = (uint16_t *)index;
+	for (i = 0; i < g_count; i++)
+		g_codepoints[i] = index[i * 2] | index[i * 2 + 1] << 8;
+
+	g_fd = fd;
+	g_bitmap_offset = PSV_FONT_HEADER_SIZE + g_count * 2;
+	return 0;
+}
+
+int psvFontFileGlyph(unsigned cp, u8 bits[PSV_FONT_GLYPH_SIZE])
+{
+	unsigned lo = 0, hi = g_count, mid;
+
+	if (g_fd < 0 || cp > 0xFFFF)
+		return 0;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (g_codepoints[mid] < cp)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == g_count || g_codepoints[lo] != cp)
+		return 0;
+
+	return fontRead(g_fd, bits, PSV_FONT_GLYPH_SIZE,
+		g_bitmap_offset + lo * PSV_FONT_GLYPH_SIZE) == PSV_FONT_GLYPH_SIZE;
+}
+
+unsigned psvUtf8Next(const char **text)
+{
+	const u8 *s = (const u8 *)*text;
+	unsigned cp, min;
+	int extra, i;
+
+	if (s[0] < 0x80) {
+		*text += 1;
+		return s[0];
+	} else if ((s[0] & 0xE0) == 0xC0) {
+		cp = s[0] & 0x1F; extra = 1; min = 0x80;
+	} else if ((s[0] & 0xF0) == 0xE0) {
+		cp = s[0] & 0x0F; extra = 2; min = 0x800;
+	} else if ((s[0] & 0xF8) == 0xF0) {
+		cp = s[0] & 0x07; extra = 3; min = 0x10000;
+	} else {
+		*text += 1;
+		return 0xFFFD;
+	}
+
+	// a NUL fails the continuation check, so this never reads past the end
+	for (i = 1; i <= extra; i++) {
+		if ((s[i] & 0xC0) != 0x80) {
+			*text += 1;
+			return 0xFFFD;
+		}
+		cp = cp << 6 | (s[i] & 0x3F);
+	}
+
+	if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+		*text += 1;
+		return 0xFFFD;
+	}
+	*text += 1 + extra;
+	return cp;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "graphics.h"
+
+// Fallback glyphs for text the built-in font can't show (Cyrillic, kana,
+// kanji...), read from a bitmap font file. Only the codepoint index is
+// loaded; glyph bitmaps stay in the file and are read one at a time, so the
+// caller is expected to cache what it draws.
+//
+// File layout, little endian:
+//   0   "PSVF"
+//   4   u16 version (1)
+//   6   u8 width, u8 height (8, 8)
+//   8   u32 count
+//   12  u16 codepoints[count], ascending
+//   ... count glyphs of 8 bytes, one per row, msb is the leftmost pixel
+// host/mkfont builds one from a BDF font.
+
+#define PSV_FONT_MAGIC "PSVF"
+#define PSV_FONT_VERSION 1
+#define PSV_FONT_HEADER_SIZE 12
+#define PSV_FONT_GLYPH_SIZE 8
+
+// replaces any font already open; < 0 if it can't be read or isn't 8x8
+int psvFontFileOpen(const char *path);
+void psvFontFileClose();
+
+// copies the 8 rows of cp to bits; 0 if the font has no such glyph
+int psvFontFileGlyph(unsigned cp, u8 bits[PSV_FONT_GLYPH_SIZE]);
+
+// decodes one UTF-8 sequence at *text and advances past it; malformed or
+// overlong input gives 0xFFFD and skips one byte
+unsigned psvUtf8Next(const char **text);
@@ -0,0 +1,108 @@
+#include "glyph.h"
+
+#include <string.h>
+
+extern u8 msx[];
+
+// rows of every scale in one block: scale 1 first, then 2, then 3
+static uint32_t g_rows[256 * 8 * (1 + 2 + 3)];
+static PsvGlyph g_glyphs[PSV_GLYPH_MAX_SCALE][256];
+static int g_ready[PSV_GLYPH_MAX_SCALE];
+
+// 4 pixel spans for every nibble, bit 0 leftmost, in the last fg/bg pair
+static Color g_spans[16][4];
+static Color g_span_fg, g_span_bg;
+static int g_spans_ready = 0;
+
+static void scaleGlyph(PsvGlyph *glyph, uint32_t *rows, const u8 *bits, int scale)
+{
+	int row, col, k, left = 8, right = -1;
+
+	// ink columns, msb is the leftmost
+	for (row = 0; row < 8; row++) {
+		for (col = 0; col < 8; col++) {
+			if (bits[row] & (0x80 >> col)) {
+				if (col < left) left = col;
+				if (col > right) right = col;
+			}
+		}
+	}
+
+	glyph->rows = rows;
+	if (right < 0) {
+		// blank glyphs, space among them, take half a cell
+		memset(rows, 0, 8 * scale * sizeof(uint32_t));
+		glyph->advance = 4 * scale;
+		return;
+	}
+	glyph->advance = (right - left + 2) * scale;
+
+	for (row = 0; row < 8; row++) {
+		uint32_t mask = 0;
+		for (col = left; col <= right; col++) {
+			if (bits[row] & (0x80 >> col))
+				mask |= ((1u << scale) - 1) << ((col - left) * scale);
+		}
+		for (k = 0; k < scale; k++)
+			rows[row * scale + k] = mask;
+	}
+}
+
+static void buildScale(int scale)
+{
+	uint32_t *rows = g_rows + 256 * 8 * (scale - 1) * scale / 2;
+	int ch;
+
+	for (ch = 0; ch < 256; ch++, rows += 8 * scale)
+		scaleGlyph(&g_glyphs[scale - 1][ch], rows, &msx[ch * 8], scale);
+	g_ready[scale - 1] = 1;
+}
+
+const PsvGlyph *psvGlyphGet(int scale, u8 ch)
+{
+	if (scale < 1 || scale > PSV_GLYPH_MAX_SCALE)
+		return NULL;
+	if (!g_ready[scale - 1])
+		buildScale(scale);
+	return &g_glyphs[scale - 1][ch];
+}
+
+const PsvGlyph *psvGlyphScale(PsvGlyph *glyph, uint32_t *rows, const u8 bits[8], int scale)
+{
+	if (scale < 1 || scale > PSV_GLYPH_MAX_SCALE)
+		return NULL;
+	scaleGlyph(glyph, rows, bits, scale);
+	return glyph;
+}
+
+static void updateSpans(Color fg, Color bg)
+{
+	int n, k;
+
+	if (g_spans_ready && g_span_fg == fg && g_span_bg == bg)
+		return;
+
+	for (n = 0; n < 16; n++)
+		for (k = 0; k < 4; k++)
+			g_spans[n][k] = (n & (1 << k)) ? fg : bg;
+
+	g_span_fg = fg;
+	g_span_bg = bg;
+	g_spans_ready = 1;
+}
+
+void psvGlyphDraw(Color *dst, int pitch, const PsvGlyph *glyph, int rows, Color fg, Color bg)
+{
+	int row, x;
+
+	updateSpans(fg, bg);
+
+	for (row = 0; row < rows; row++, dst += pitch) {
+		uint32_t mask = glyph->rows[row];
+
+		for (x = 0; x + 4 <= glyph->advance; x += 4, mask >>= 4)
+			memcpy(dst + x, g_spans[mask & 0xF], 4 * sizeof(Color));
+		for (; x < glyph->advance; x++, mask >>= 1)
+			dst[x] = (mask & 1) ? fg : bg;
+	}
+}
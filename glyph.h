@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "graphics.h"
+
+// The 8x8 font scaled up for large print. Each scale is expanded once, on
+// first use, into row masks trimmed to the glyph's ink, so drawing never
+// scales anything and text can advance by each glyph's own width.
+
+#define PSV_GLYPH_MAX_SCALE 3
+
+typedef struct {
+	const uint32_t *rows;	// 8 * scale masks, leftmost pixel in bit 0
+	u8 advance;				// pixels the pen moves, ink plus a gap
+} PsvGlyph;
+
+// NULL when scale is not 1 to PSV_GLYPH_MAX_SCALE
+const PsvGlyph *psvGlyphGet(int scale, u8 ch);
+
+// the same for a glyph that isn't in the built-in font, built into the
+// caller's storage; rows holds 8 * scale masks
+const PsvGlyph *psvGlyphScale(PsvGlyph *glyph, uint32_t *rows, const u8 bits[8], int scale);
+
+// paints the glyph's advance x rows box at dst, ink in fg and the rest in
+// bg; rows is at most 8 * scale (pitch is in pixels)
+void psvGlyphDraw(Color *dst, int pitch, const PsvGlyph *glyph, int rows, Color fg, Color bg);
@@ -1,126 +1,913 @@
 #include "graphics.h"
+#include "fill.h"
+#include "glyph.h"
+#include "fontfile.h"
+#include "logq.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <stdarg.h>
 
+#ifdef __vita__
 #define SCE_DISPLAY_UPDATETIMING_NEXTVSYNC SCE_DISPLAY_SETBUF_NEXTFRAME
 #include <psp2/display.h>
 #include <psp2/kernel/sysmem.h>
 #include <psp2/kernel/threadmgr.h>
+#endif
 
 enum {
 	SCREEN_WIDTH = 960,
 	SCREEN_HEIGHT = 544,
 	LINE_SIZE = 960,
 	FRAMEBUFFER_SIZE = 2 * 1024 * 1024,
-	FRAMEBUFFER_ALIGNMENT = 256 * 1024
+	FRAMEBUFFER_COUNT = 2,
+	FRAMEBUFFER_ALIGNMENT = 256 * 1024,
+	CHAR_WIDTH = 8,
+	CHAR_HEIGHT = 9,
+	TEXT_COLS = SCREEN_WIDTH / CHAR_WIDTH,
+	TEXT_ROWS = SCREEN_HEIGHT / CHAR_HEIGHT,
+	DEFAULT_SCROLLBACK = 128
 };
 
-typedef union
-{
-	int rgba;
-	struct
-	{
-		char r;
-		char g;
-		char b;
-		char a;
-	} c;
-} color_t;
+// one character cell of the console, ch is a BMP codepoint, 0 an empty cell
+typedef struct {
+	Color fg;
+	Color bg;
+	uint16_t ch;
+	u8 stale;    // shadow only: pixels under this cell are unknown
+	u8 overlay;  // shadow only: a fill was drawn over this cell
+} Cell;
 
 extern u8 msx[];
-void* g_vram_base;
+void* g_vram_base; // buffer drawing goes to, see psvDebugScreenBeginFrame
+static Color *g_buffers[FRAMEBUFFER_COUNT];
+static int g_front = 0;
+static int g_in_frame = 0;
 static int gX = 0;
 static int gY = 0;
 
 static Color g_fg_color;
 static Color g_bg_color;
 
+static const PsvFramebufferBackend *g_backend;
+static PsvDebugScreenStats g_stats;
+
+// Console text: a ring of TEXT_COLS wide lines holding the page plus
+// g_scrollback lines of history. The page is g_page_rows lines, starting at
+// absolute line g_top, and screen row 0 shows page row g_view (negative
+// looks into the history). g_page_used is how far down text was printed.
+static Cell *g_lines = NULL;
+static int g_line_capacity = 0;
+static int g_scrollback = DEFAULT_SCROLLBACK;
+static int g_page_rows = TEXT_ROWS;
+static int g_page_used = 0;
+static int g_top = 0;
+static int g_view = 0;
+static int g_first_line = 0;	// oldest line with text, older ones are blank
+
+// The pixel rows below the last text row, painted with the last clear color.
+static Color g_band_color;
+
+// What each framebuffer currently shows: the cells it was last rasterized
+// from, the absolute line that was on row 0 and the band color. Rasterizing
+// diffs the ring against this and only redraws cells that changed.
+static Cell g_shadow[FRAMEBUFFER_COUNT][TEXT_ROWS * TEXT_COLS];
+static int g_shadow_top[FRAMEBUFFER_COUNT];
+static Color g_shadow_band[FRAMEBUFFER_COUNT];
+static int g_shadow_band_valid[FRAMEBUFFER_COUNT];
+static int g_shadow_band_overlay[FRAMEBUFFER_COUNT];
+
+// Dirty tracking, so rows nobody touched are not even compared: ring lines
+// written since a buffer last rasterized them (indexed by ring slot), and
+// screen rows whose pixels a buffer no longer trusts (in shadow order).
+static u8 *g_line_dirty[FRAMEBUFFER_COUNT];
+static u8 g_row_stale[FRAMEBUFFER_COUNT][TEXT_ROWS];
+
+static void flushCommands();
+static void submitCommands();
+static void dropCommands();
+
 static Color* getVramDisplayBuffer()
 {
 	Color* vram = (Color*) g_vram_base;
 	return vram;
 }
 
+static int drawBufferIndex()
+{
+	return g_in_frame ? (g_front + 1) % FRAMEBUFFER_COUNT : g_front;
+}
+
 void *psvDebugScreenGetVram() {
 	return g_vram_base;
 }
 
 int psvDebugScreenGetX() {
+	flushCommands();
 	return gX;
 }
 
 int psvDebugScreenGetY() {
+	flushCommands();
 	return gY;
 }
 
 void psvDebugScreenSetXY(int x, int y) {
+	flushCommands();
 	gX = x;
 	gY = y;
 }
 
- // #define LOG(args...)  		vita_logf (__FILE__, __LINE__, args)  ///< Write a log entry
+int psvDebugScreenGetWidth() {
+	return SCREEN_WIDTH;
+}
 
-int g_log_mutex;
+int psvDebugScreenGetHeight() {
+	return SCREEN_HEIGHT;
+}
 
-void psvDebugScreenInit() {
-	g_log_mutex = sceKernelCreateMutex("log_mutex", 0, 0, NULL);
+int psvDebugScreenGetPitch() {
+	return LINE_SIZE;
+}
+
+void psvDebugScreenGetStats(PsvDebugScreenStats *stats) {
+	*stats = g_stats;
+}
+
+void psvDebugScreenResetStats() {
+	memset(&g_stats, 0, sizeof(g_stats));
+}
+
+/********************* glyph expansion *********************************/
+
+// msx[] expanded once into 9 rows of 9 pixel masks per glyph, leftmost pixel
+// in bit 8. The old renderer drew every font bit as an overlapping 2x2 block,
+// which left the 8th row and column repeated one pixel further; the masks
+// bake that in so the output stays identical with one store per pixel.
+static uint16_t g_glyph_masks[256][9];
+static int g_glyph_masks_ready = 0;
+
+// 4 pixel spans for every nibble, colored with the current fg/bg pair
+static Color g_spans[16][4];
+static Color g_span_fg, g_span_bg;
+static int g_spans_ready = 0;
+
+static void expandMasks(uint16_t *mask, const u8 *bits)
+{
+	int row;
+
+	for (row = 0; row < 9; row++) {
+		u8 b = bits[row < 8 ? row : 7];
+		mask[row] = (b << 1) | (b & 1);
+	}
+}
+
+static void expandGlyphs()
+{
+	int ch;
+
+	for (ch = 0; ch < 256; ch++)
+		expandMasks(g_glyph_masks[ch], &msx[ch * 8]);
+	g_glyph_masks_ready = 1;
+}
+
+// Everything past ASCII comes from the font file (see fontfile.h), through
+// a direct mapped cache indexed by the low bits of the codepoint. A miss is
+// a binary search and one small read; glyphs the font lacks are cached as
+// '?' the same way, so text that repeats costs about what ASCII does.
+#define GLYPH_CACHE_SIZE 256
+
+typedef struct {
+	uint16_t ch;
+	u8 valid;
+	u8 bits[8];			// for large print
+	uint16_t masks[9];	// for the console, as g_glyph_masks
+} CachedGlyph;
+
+static CachedGlyph g_glyph_cache[GLYPH_CACHE_SIZE];
+
+static CachedGlyph *cachedGlyph(unsigned ch)
+{
+	CachedGlyph *slot = &g_glyph_cache[ch % GLYPH_CACHE_SIZE];
+
+	if (slot->valid && slot->ch == ch)
+		return slot;
+
+	if (!psvFontFileGlyph(ch, slot->bits))
+		memcpy(slot->bits, &msx['?' * 8], 8);
+	expandMasks(slot->masks, slot->bits);
+	slot->ch = ch;
+	slot->valid = 1;
+	return slot;
+}
+
+static const uint16_t *glyphMasks(unsigned ch)
+{
+	return ch < 0x80 ? g_glyph_masks[ch] : cachedGlyph(ch)->masks;
+}
+
+static void updateSpans(Color fg, Color bg)
+{
+	int n, k;
+
+	if (g_spans_ready && g_span_fg == fg && g_span_bg == bg)
+		return;
+
+	for (n = 0; n < 16; n++)
+		for (k = 0; k < 4; k++)
+			g_spans[n][k] = (n & (8 >> k)) ? fg : bg;
+
+	g_span_fg = fg;
+	g_span_bg = bg;
+	g_spans_ready = 1;
+}
+
+// Draws the 8x9 pixels of one cell. The repeated 9th glyph column only
+// shows where the next cell is empty, so an empty cell takes its first
+// column from the glyph on its left instead of it being drawn over.
+static void drawCell(Color *vram, const Cell *cell, const Cell *left)
+{
+	int row;
+
+	if (cell->ch == 0 && left && left->ch != 0) {
+		const uint16_t *mask = glyphMasks(left->ch);
+		updateSpans(cell->bg, cell->bg);
+		for (row = 0; row < 9; row++, vram += LINE_SIZE) {
+			memcpy(vram, g_spans[0], 4 * sizeof(Color));
+			memcpy(vram + 4, g_spans[0], 4 * sizeof(Color));
+			vram[0] = (mask[row] & 1) ? left->fg : left->bg;
+		}
+	} else {
+		const uint16_t *mask = glyphMasks(cell->ch);
+		updateSpans(cell->fg, cell->bg);
+		for (row = 0; row < 9; row++, vram += LINE_SIZE) {
+			memcpy(vram, g_spans[mask[row] >> 5], 4 * sizeof(Color));
+			memcpy(vram + 4, g_spans[(mask[row] >> 1) & 0xF], 4 * sizeof(Color));
+		}
+	}
+	g_stats.glyphs++;
+	g_stats.bytes_written += CHAR_WIDTH * CHAR_HEIGHT * sizeof(Color);
+}
+
+/********************* console text *********************************/
+
+static Cell *lineAt(int line)
+{
+	return g_lines + (line % g_line_capacity) * TEXT_COLS;
+}
+
+static void markLineDirty(int line)
+{
+	int buf;
+
+	for (buf = 0; buf < FRAMEBUFFER_COUNT; buf++)
+		g_line_dirty[buf][line % g_line_capacity] = 1;
+}
+
+static void blankLine(int line, Color bg)
+{
+	Cell blank = { bg, bg, 0, 0, 0 };
+	Cell *cell = lineAt(line);
+	int i;
+
+	for (i = 0; i < TEXT_COLS; i++)
+		cell[i] = blank;
+	markLineDirty(line);
+}
+
+// (re)allocates the ring, keeping as much of the newest text as fits; the
+// rest of it starts out blank
+static int allocLines(int scrollback)
+{
+	int capacity = scrollback + g_page_rows;
+	int keep = g_top + g_page_rows;
+	Cell blank = { g_bg_color, g_bg_color, 0, 0, 0 };
+	Cell *lines;
+	u8 *dirty;
+	int fresh = g_lines == NULL;
+	int i;
+
+	// the per buffer dirty flags of every line live right after the cells
+	lines = malloc(capacity * (TEXT_COLS * sizeof(Cell) + FRAMEBUFFER_COUNT));
+	if (lines == NULL)
+		return -1;
+	dirty = (u8 *)(lines + capacity * TEXT_COLS);
+	memset(dirty, 1, capacity * FRAMEBUFFER_COUNT);
+	for (i = 0; i < capacity * TEXT_COLS; i++)
+		lines[i] = blank;
+
+	if (fresh) {
+		g_first_line = g_top;
+	} else {
+		if (keep > g_line_capacity)
+			keep = g_line_capacity;
+		if (keep > capacity)
+			keep = capacity;
+		for (i = g_top + g_page_rows - keep; i < g_top + g_page_rows; i++)
+			memcpy(lines + (i % capacity) * TEXT_COLS, lineAt(i), TEXT_COLS * sizeof(Cell));
+		free(g_lines);
+		if (g_first_line < g_top + g_page_rows - keep)
+			g_first_line = g_top + g_page_rows - keep;
+	}
 
+	g_lines = lines;
+	g_line_capacity = capacity;
+	g_scrollback = scrollback;
+	for (i = 0; i < FRAMEBUFFER_COUNT; i++)
+		g_line_dirty[i] = dirty + i * capacity;
+	return 0;
+}
+
+static void invalidateShadow(int buf)
+{
+	int i;
+
+	for (i = 0; i < TEXT_ROWS * TEXT_COLS; i++) {
+		g_shadow[buf][i].stale = 1;
+		g_shadow[buf][i].overlay = 0;
+	}
+	memset(g_row_stale[buf], 1, TEXT_ROWS);
+	g_shadow_band_valid[buf] = 0;
+	g_shadow_band_overlay[buf] = 0;
+}
+
+static void recordCell(uint16_t ch)
+{
+	int row = gY / CHAR_HEIGHT;
+	int col = gX / CHAR_WIDTH;
+	Cell *cell;
+
+	if (!g_lines || row < 0 || row >= g_page_rows || col < 0 || col >= TEXT_COLS)
+		return;
+	if (row >= g_page_used)
+		g_page_used = row + 1;
+
+	cell = lineAt(g_top + row) + col;
+	cell->fg = g_fg_color;
+	cell->bg = g_bg_color;
+	cell->ch = ch;
+	markLineDirty(g_top + row);
+}
+
+// Moves the pixels and shadow of `buf` by `delta` text rows (positive is
+// up) so that rows still on screen after a scroll are not redrawn. The rows
+// that come into view are left stale. Costs one screen of pixels at most.
+static void shiftBuffer(int buf, int delta)
+{
+	Cell *shadow = g_shadow[buf];
+	u8 *dirty = g_row_stale[buf];
+	int keep = TEXT_ROWS - (delta < 0 ? -delta : delta);
+	int i;
+
+	if (keep <= 0) {
+		for (i = 0; i < TEXT_ROWS * TEXT_COLS; i++)
+			shadow[i].stale = 1;
+		memset(dirty, 1, TEXT_ROWS);
+		return;
+	}
+
+	if (delta > 0) {
+		psvFillMoveRows(g_buffers[buf], LINE_SIZE, SCREEN_WIDTH, 0, delta * CHAR_HEIGHT, keep * CHAR_HEIGHT);
+		memmove(shadow, shadow + delta * TEXT_COLS, keep * TEXT_COLS * sizeof(Cell));
+		memmove(dirty, dirty + delta, keep);
+		for (i = keep * TEXT_COLS; i < TEXT_ROWS * TEXT_COLS; i++)
+			shadow[i].stale = 1;
+		memset(dirty + keep, 1, delta);
+	} else {
+		psvFillMoveRows(g_buffers[buf], LINE_SIZE, SCREEN_WIDTH, -delta * CHAR_HEIGHT, 0, keep * CHAR_HEIGHT);
+		memmove(shadow - delta * TEXT_COLS, shadow, keep * TEXT_COLS * sizeof(Cell));
+		memmove(dirty - delta, dirty, keep);
+		for (i = 0; i < -delta * TEXT_COLS; i++)
+			shadow[i].stale = 1;
+		memset(dirty, 1, -delta);
+	}
+	g_stats.bytes_written += keep * CHAR_HEIGHT * SCREEN_WIDTH * sizeof(Color);
+	g_stats.scrolls++;
+}
+
+static int sameCell(const Cell *a, const Cell *b)
+{
+	return a->ch == b->ch && a->fg == b->fg && a->bg == b->bg;
+}
+
+// brings the draw buffer up to date with the visible part of the ring
+static void rasterize()
+{
+	int buf = drawBufferIndex();
+	int top = g_top + g_view;
+	Color *vram = g_buffers[buf];
+	Cell *shadow = g_shadow[buf];
+	int row, col;
+
+	if (!g_lines || !vram)
+		return;
+
+	if (top != g_shadow_top[buf]) {
+		shiftBuffer(buf, top - g_shadow_top[buf]);
+		g_shadow_top[buf] = top;
+	}
+
+	if (!g_shadow_band_overlay[buf] &&
+			(!g_shadow_band_valid[buf] || g_shadow_band[buf] != g_band_color)) {
+		psvFillRows(vram, LINE_SIZE, SCREEN_WIDTH, TEXT_ROWS * CHAR_HEIGHT,
+			SCREEN_HEIGHT - TEXT_ROWS * CHAR_HEIGHT, g_band_color);
+		g_shadow_band[buf] = g_band_color;
+		g_shadow_band_valid[buf] = 1;
+	}
+
+	for (row = 0; row < TEXT_ROWS; row++) {
+		const Cell *line = lineAt(top + row);
+		Cell *drawn = shadow + row * TEXT_COLS;
+		Color *pixels = vram + row * CHAR_HEIGHT * LINE_SIZE;
+		int left_changed = 0;
+
+		u8 *line_dirty = &g_line_dirty[buf][(top + row) % g_line_capacity];
+
+		if (!*line_dirty && !g_row_stale[buf][row])
+			continue;
+		*line_dirty = 0;
+		g_row_stale[buf][row] = 0;
+
+		for (col = 0; col < TEXT_COLS; col++) {
+			int changed = drawn[col].stale || !sameCell(&line[col], &drawn[col]);
+
+			// an empty cell shows the edge of the glyph to its left
+			if (changed || (left_changed && line[col].ch == 0)) {
+				drawCell(pixels + col * CHAR_WIDTH, &line[col], col ? &line[col - 1] : NULL);
+				drawn[col] = line[col];
+				drawn[col].stale = 0;
+				drawn[col].overlay = 0;
+			}
+			left_changed = changed;
+		}
+	}
+}
+
+/********************* framebuffer backends *********************************/
+
+#ifdef __vita__
+
+static SceUID g_displayblock = -1;
+
+static void *vitaAlloc(unsigned size)
+{
 	SceKernelAllocMemBlockOpt opt = { 0 };
 	opt.size = sizeof(opt);
 	opt.attr = 0x00000004;
 	opt.alignment = FRAMEBUFFER_ALIGNMENT;
-	SceUID displayblock = sceKernelAllocMemBlock("display", SCE_KERNEL_MEMBLOCK_TYPE_USER_CDRAM_RW, FRAMEBUFFER_SIZE, &opt);
-	printf("displayblock: 0x%08x", displayblock);
+	g_displayblock = sceKernelAllocMemBlock("display", SCE_KERNEL_MEMBLOCK_TYPE_USER_CDRAM_RW, size, &opt);
+	printf("displayblock: 0x%08x", g_displayblock);
+	if (g_displayblock < 0)
+		return NULL;
+
 	void *base;
-	sceKernelGetMemBlockBase(displayblock, &base);
+	sceKernelGetMemBlockBase(g_displayblock, &base);
 	// LOG("base: 0x%08x", base);
+	return base;
+}
 
+static void vitaFree(void *base)
+{
+	if (g_displayblock >= 0)
+		sceKernelFreeMemBlock(g_displayblock);
+	g_displayblock = -1;
+}
+
+static void vitaSetDisplay(void *base, int pitch, int width, int height)
+{
 	SceDisplayFrameBuf framebuf = { 0 };
 	framebuf.size = sizeof(framebuf);
 	framebuf.base = base;
-	framebuf.pitch = SCREEN_WIDTH;
+	framebuf.pitch = pitch;
 	framebuf.pixelformat = SCE_DISPLAY_PIXELFORMAT_A8B8G8R8;
-	framebuf.width = SCREEN_WIDTH;
-	framebuf.height = SCREEN_HEIGHT;
-
-	g_vram_base = base;
+	framebuf.width = width;
+	framebuf.height = height;
 
 	sceDisplaySetFrameBuf(&framebuf, SCE_DISPLAY_UPDATETIMING_NEXTVSYNC);
+}
+
+static void vitaWaitVblank()
+{
+	// returns once the buffer passed to vitaSetDisplay is being scanned out
+	sceDisplayWaitSetFrameBuf();
+}
+
+const PsvFramebufferBackend psvDefaultFramebufferBackend = {
+	vitaAlloc,
+	vitaFree,
+	vitaSetDisplay,
+	vitaWaitVblank,
+};
+
+#else
+
+// host: a plain buffer in memory, nothing is scanned out
+static void *hostAlloc(unsigned size)
+{
+	return calloc(1, size);
+}
+
+static void hostFree(void *base)
+{
+	free(base);
+}
+
+static void hostSetDisplay(void *base, int pitch, int width, int height)
+{
+}
+
+static void hostWaitVblank()
+{
+}
+
+const PsvFramebufferBackend psvDefaultFramebufferBackend = {
+	hostAlloc,
+	hostFree,
+	hostSetDisplay,
+	hostWaitVblank,
+};
+
+#endif
 
+ // #define LOG(args...)  		vita_logf (__FILE__, __LINE__, args)  ///< Write a log entry
+
+#ifdef __vita__
+int g_log_mutex;
+#define LOCK_LOG()   sceKernelLockMutex(g_log_mutex, 1, NULL)
+#define UNLOCK_LOG() sceKernelUnlockMutex(g_log_mutex, 1)
+#else
+#define LOCK_LOG()
+#define UNLOCK_LOG()
+#endif
+
+int psvDebugScreenInitBackend(const PsvFramebufferBackend *backend) {
+#ifdef __vita__
+	g_log_mutex = sceKernelCreateMutex("log_mutex", 0, 0, NULL);
+#endif
+
+	int i;
+
+	// one block, each buffer starting on a FRAMEBUFFER_SIZE boundary
+	g_backend = backend;
+	memset(g_buffers, 0, sizeof(g_buffers));
+	g_buffers[0] = g_backend->alloc(FRAMEBUFFER_SIZE * FRAMEBUFFER_COUNT);
+	if (g_buffers[0]) {
+		for (i = 1; i < FRAMEBUFFER_COUNT; i++)
+			g_buffers[i] = g_buffers[0] + i * (FRAMEBUFFER_SIZE / sizeof(Color));
+	}
+
+	g_front = 0;
+	g_in_frame = 0;
+	g_vram_base = g_buffers[g_front];
+	if (g_vram_base)
+		g_backend->set_display(g_vram_base, LINE_SIZE, SCREEN_WIDTH, SCREEN_HEIGHT);
+
+	gX = gY = 0;
 	g_fg_color = 0xFFFFFFFF;
 	g_bg_color = 0x00000000;
+	g_band_color = g_bg_color;
+
+	if (!g_glyph_masks_ready)
+		expandGlyphs();
+
+	free(g_lines);
+	g_lines = NULL;
+	g_top = g_view = g_page_used = 0;
+	if (allocLines(g_scrollback) < 0)
+		allocLines(0);
+
+	// whatever the memory held before, the first rasterize paints it all
+	for (i = 0; i < FRAMEBUFFER_COUNT; i++) {
+		invalidateShadow(i);
+		g_shadow_top[i] = 0;
+	}
+	return g_buffers[0] ? 0 : -1;
+}
+
+int psvDebugScreenInit() {
+	return psvDebugScreenInitBackend(&psvDefaultFramebufferBackend);
+}
+
+void psvDebugScreenTerm() {
+	if (g_backend && g_buffers[0])
+		g_backend->free(g_buffers[0]);
+	memset(g_buffers, 0, sizeof(g_buffers));
+	g_vram_base = NULL;
+	g_backend = NULL;
+
+	free(g_lines);
+	g_lines = NULL;
+	g_line_capacity = 0;
+	dropCommands();
+
+	psvFontFileClose();
+	memset(g_glyph_cache, 0, sizeof(g_glyph_cache));
+}
+
+int psvDebugScreenLoadFont(const char *path) {
+	int ret, i;
+
+	LOCK_LOG();
+	ret = psvFontFileOpen(path);
+	memset(g_glyph_cache, 0, sizeof(g_glyph_cache));
+	// text already on screen may have been drawn with the old glyphs
+	for (i = 0; i < FRAMEBUFFER_COUNT; i++)
+		invalidateShadow(i);
+	UNLOCK_LOG();
+	return ret;
+}
+
+int psvDebugScreenSetScrollback(int lines) {
+	int ret;
+
+	if (lines < 0)
+		lines = 0;
+	if (g_lines == NULL) {
+		g_scrollback = lines;
+		return 0;
+	}
+
+	LOCK_LOG();
+	submitCommands();
+	g_view = 0;
+	ret = allocLines(lines);
+	if (!g_in_frame)
+		rasterize();
+	UNLOCK_LOG();
+	return ret;
+}
+
+int psvDebugScreenScrollBack(int lines) {
+	// lines before g_first_line were never printed or didn't survive a resize
+	int history = g_top - g_first_line < g_scrollback ? g_top - g_first_line : g_scrollback;
+
+	if (!g_lines)
+		return 0;
+	if (lines < 0)
+		lines = 0;
+	if (lines > history)
+		lines = history;
+
+	LOCK_LOG();
+	submitCommands();
+	g_view = -lines;
+	if (!g_in_frame)
+		rasterize();
+	UNLOCK_LOG();
+	return lines;
+}
+
+int psvDebugScreenSetPageRows(int rows) {
+	int ret, i;
+
+	if (rows < TEXT_ROWS)
+		rows = TEXT_ROWS;
+
+	LOCK_LOG();
+	dropCommands();
+	free(g_lines);
+	g_lines = NULL;
+	g_page_rows = rows;
+	g_top = g_view = g_page_used = 0;
+	gX = gY = 0;
+	ret = allocLines(g_scrollback);
+	if (ret < 0) {
+		g_page_rows = TEXT_ROWS;
+		if (allocLines(g_scrollback) < 0)
+			allocLines(0);
+	}
+	for (i = 0; i < FRAMEBUFFER_COUNT; i++) {
+		invalidateShadow(i);
+		g_shadow_top[i] = 0;
+	}
+	if (!g_in_frame)
+		rasterize();
+	UNLOCK_LOG();
+	return ret < 0 ? ret : rows;
+}
+
+// Moving the view by n rows shifts the pixels already on screen and draws
+// only the n rows that come into view, however long the page is.
+int psvDebugScreenSetView(int y) {
+	int row = y / CHAR_HEIGHT;
+	int last;
+
+	LOCK_LOG();
+	submitCommands();
+	last = g_page_used - TEXT_ROWS;
+	if (row > last)
+		row = last;
+	if (row < 0)
+		row = 0;
+	if (g_lines && row != g_view) {
+		g_view = row;
+		if (!g_in_frame)
+			rasterize();
+	}
+	UNLOCK_LOG();
+	return row * CHAR_HEIGHT;
+}
+
+int psvDebugScreenGetView() {
+	return g_view > 0 ? g_view * CHAR_HEIGHT : 0;
+}
+
+void psvDebugScreenBeginFrame() {
+	Cell *shadow;
+	int i;
+
+	if (g_in_frame)
+		return;
+
+	LOCK_LOG();
+	g_in_frame = 1;
+	g_vram_base = g_buffers[drawBufferIndex()];
+
+	// fills from the last frame drawn into this buffer are not kept, the
+	// text under them is restored unless they get drawn again
+	shadow = g_shadow[drawBufferIndex()];
+	for (i = 0; i < TEXT_ROWS * TEXT_COLS; i++) {
+		if (shadow[i].overlay) {
+			shadow[i].stale = 1;
+			shadow[i].overlay = 0;
+			g_row_stale[drawBufferIndex()][i / TEXT_COLS] = 1;
+		}
+	}
+	if (g_shadow_band_overlay[drawBufferIndex()]) {
+		g_shadow_band_overlay[drawBufferIndex()] = 0;
+		g_shadow_band_valid[drawBufferIndex()] = 0;
+	}
+	UNLOCK_LOG();
+}
+
+void psvDebugScreenEndFrame() {
+	if (!g_in_frame)
+		return;
+
+	LOCK_LOG();
+	submitCommands();
+	rasterize();
+
+	if (g_buffers[0]) {
+		g_front = (g_front + 1) % FRAMEBUFFER_COUNT;
+		g_backend->set_display(g_buffers[g_front], LINE_SIZE, SCREEN_WIDTH, SCREEN_HEIGHT);
+		g_backend->wait_vblank();
+	}
+
+	g_vram_base = g_buffers[g_front];
+	g_in_frame = 0;
+	g_stats.frames++;
+	UNLOCK_LOG();
 }
 
 void psvDebugScreenClear(int bg_color)
 {
+	int buf = drawBufferIndex();
+	Cell blank = { bg_color, bg_color, 0, 0, 0 };
+	int row, i;
+
+	flushCommands();
 	gX = gY = 0;
-	int i;
-	color_t *pixel = (color_t *)getVramDisplayBuffer();
-	for(i = 0; i < SCREEN_WIDTH * SCREEN_HEIGHT; i++) {
-		pixel->rgba = bg_color;
-		pixel++;
+	g_view = g_page_used = 0;
+	g_band_color = bg_color;
+	if (g_lines) {
+		for (row = 0; row < g_page_rows; row++)
+			blankLine(g_top + row, bg_color);
+	}
+	memset(g_row_stale[buf], 0, TEXT_ROWS);
+	// cheaper to fill the draw buffer outright than to diff every cell
+	if (getVramDisplayBuffer())
+		psvFillSpan(getVramDisplayBuffer(), SCREEN_WIDTH * SCREEN_HEIGHT, bg_color);
+	for (i = 0; i < TEXT_ROWS * TEXT_COLS; i++)
+		g_shadow[buf][i] = blank;
+	g_shadow_top[buf] = g_top;
+	g_shadow_band[buf] = bg_color;
+	g_shadow_band_valid[buf] = 1;
+	g_shadow_band_overlay[buf] = 0;
+
+	g_stats.clears++;
+	g_stats.bytes_written += SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(Color);
+}
+
+// the cells under an on-screen rectangle are restored on the next frame
+// drawn into this buffer
+static void markOverlay(int x, int y, int w, int h)
+{
+	Cell *shadow = g_shadow[drawBufferIndex()];
+	int row, col;
+
+	for (row = y / CHAR_HEIGHT; row <= (y + h - 1) / CHAR_HEIGHT && row < TEXT_ROWS; row++)
+		for (col = x / CHAR_WIDTH; col <= (x + w - 1) / CHAR_WIDTH; col++)
+			shadow[row * TEXT_COLS + col].overlay = 1;
+	if (y + h > TEXT_ROWS * CHAR_HEIGHT)
+		g_shadow_band_overlay[drawBufferIndex()] = 1;
+}
+
+void psvDebugScreenFillRect(int x, int y, int w, int h, Color color)
+{
+	if (x < 0) { w += x; x = 0; }
+	if (y < 0) { h += y; y = 0; }
+	if (x + w > SCREEN_WIDTH) w = SCREEN_WIDTH - x;
+	if (y + h > SCREEN_HEIGHT) h = SCREEN_HEIGHT - y;
+	if (w <= 0 || h <= 0 || !getVramDisplayBuffer())
+		return;
+
+	// text printed so far goes under the fill, not over it
+	flushCommands();
+	rasterize();
+
+	psvFillRect(getVramDisplayBuffer(), LINE_SIZE, x, y, w, h, color);
+	g_stats.bytes_written += w * h * sizeof(Color);
+	markOverlay(x, y, w, h);
+}
+
+void psvDebugScreenClearRows(int y, int rows, Color color)
+{
+	psvDebugScreenFillRect(0, y, SCREEN_WIDTH, rows, color);
+}
+
+// large print glyph for ch, scaled into the caller's storage past ASCII
+static const PsvGlyph *scaledGlyph(unsigned ch, int scale, PsvGlyph *glyph, uint32_t *rows)
+{
+	if (ch < 0x80)
+		return psvGlyphGet(scale, ch);
+	return psvGlyphScale(glyph, rows, cachedGlyph(ch <= 0xFFFF ? ch : 0xFFFD)->bits, scale);
+}
+
+int psvDebugScreenTextWidth(int scale, const char *text)
+{
+	PsvGlyph scratch;
+	uint32_t rows[8 * PSV_GLYPH_MAX_SCALE];
+	int width = 0;
+
+	if (!psvGlyphGet(scale, 0))
+		return 0;
+	while (*text)
+		width += scaledGlyph(psvUtf8Next(&text), scale, &scratch, rows)->advance;
+	return width;
+}
+
+int psvDebugScreenDrawText(int x, int y, int scale, const char *text)
+{
+	const PsvGlyph *glyph;
+	PsvGlyph scratch;
+	uint32_t scratch_rows[8 * PSV_GLYPH_MAX_SCALE];
+	int start = x;
+	int rows = 8 * scale;
+
+	if (!psvGlyphGet(scale, 0) || !getVramDisplayBuffer() || x < 0 || y < 0 || y >= SCREEN_HEIGHT)
+		return 0;
+	if (y + rows > SCREEN_HEIGHT)
+		rows = SCREEN_HEIGHT - y;
+
+	// same as a fill, console text goes under it
+	flushCommands();
+	rasterize();
+
+	while (*text) {
+		glyph = scaledGlyph(psvUtf8Next(&text), scale, &scratch, scratch_rows);
+		if (x + glyph->advance > SCREEN_WIDTH)
+			break;
+		psvGlyphDraw(getVramDisplayBuffer() + y * LINE_SIZE + x, LINE_SIZE, glyph, rows,
+			g_fg_color, g_bg_color);
+		x += glyph->advance;
+		g_stats.glyphs++;
+		g_stats.bytes_written += glyph->advance * rows * sizeof(Color);
 	}
+
+	if (x > start)
+		markOverlay(start, y, x - start, rows);
+	return x - start;
 }
 
 static void printTextScreen(const char * text)
 {
-	int c, i, j, l;
-	u8 *font;
-	Color *vram_ptr;
-	Color *vram;
+	unsigned ch;
+
+	if (!g_glyph_masks_ready)
+		expandGlyphs();
 
-	for (c = 0; c < strlen(text); c++) {
+	// new output brings the console back from the history, though not
+	// to the cursor: a page taller than the screen stays where it is viewed
+	if (g_view < 0)
+		g_view = 0;
+
+	while (*text) {
 		if (gX + 8 > SCREEN_WIDTH) {
 			gY += 9;
 			gX = 0;
 		}
-		if (gY + 9 > SCREEN_HEIGHT) {
-			gY = 0;
-			psvDebugScreenClear(g_bg_color);
+		// scrolling only moves the ring, the pixels follow in rasterize()
+		while (gY + 9 > SCREEN_HEIGHT + (g_page_rows - TEXT_ROWS) * CHAR_HEIGHT) {
+			gY -= CHAR_HEIGHT;
+			if (g_lines) {
+				g_top++;
+				blankLine(g_top + g_page_rows - 1, g_bg_color);
+			}
 		}
-		char ch = text[c];
+		ch = psvUtf8Next(&text);
 		if (ch == '\n') {
 			gX = 0;
 			gY += 9;
@@ -130,43 +917,187 @@ static void printTextScreen(const char * text)
 			continue;
 		}
 
-		vram = getVramDisplayBuffer() + gX + gY * LINE_SIZE;
-
-		font = &msx[ (int)ch * 8];
-		for (i = l = 0; i < 8; i++, l += 8, font++) {
-			vram_ptr  = vram;
-			for (j = 0; j < 8; j++) {
-				if ((*font & (128 >> j))) {
-					*(uint32_t *)(vram_ptr) = g_fg_color;
-					*(uint32_t *)(vram_ptr + 1) = g_fg_color;
-					*(uint32_t *)(vram_ptr + LINE_SIZE) = g_fg_color;
-					*(uint32_t *)(vram_ptr + LINE_SIZE + 1) = g_fg_color;
-				} else {
-					*(uint32_t *)(vram_ptr) = g_bg_color;
-					*(uint32_t *)(vram_ptr + 1) = g_bg_color;
-					*(uint32_t *)(vram_ptr + LINE_SIZE) = g_bg_color;
-					*(uint32_t *)(vram_ptr + LINE_SIZE + 1) = g_bg_color;
-				}
-				vram_ptr += 1;
-			}
-			vram += 1 * LINE_SIZE;
-		}
+		recordCell(ch <= 0xFFFF ? ch : 0xFFFD);
 		gX += 8;
 	}
+
+	// outside a frame text shows up as soon as it is printed
+	if (!g_in_frame)
+		rasterize();
+}
+
+/********************* frame command buffer *********************************/
+
+// Inside a frame, printed text is queued and laid out in one pass, under
+// one lock, when the frame ends or something needs the console as it is
+// (the cursor, a fill, large print). Text in the same colors as the
+// command before it extends that command, so "\n" after a value or a
+// header after blank lines cost nothing extra. Outside a frame every
+// print is laid out and drawn right away, as before.
+#define CMD_MAX 128
+#define CMD_TEXT 8192
+
+typedef struct {
+	Color fg, bg;
+	int start, len;		// text in g_cmd_text, NUL terminated
+	int *x, *y;			// set for cursor marks, which carry no text
+} DrawCommand;
+
+static DrawCommand g_cmds[CMD_MAX];
+static int g_cmd_count = 0;
+static char g_cmd_text[CMD_TEXT];
+static int g_cmd_used = 0;
+
+// caller holds the lock
+static void submitCommands()
+{
+	Color fg = g_fg_color, bg = g_bg_color;
+	int i;
+
+	for (i = 0; i < g_cmd_count; i++) {
+		DrawCommand *cmd = &g_cmds[i];
+
+		if (cmd->x) {
+			*cmd->x = gX;
+			*cmd->y = gY;
+			continue;
+		}
+		g_fg_color = cmd->fg;
+		g_bg_color = cmd->bg;
+		printTextScreen(g_cmd_text + cmd->start);
+		g_stats.runs++;
+	}
+	g_fg_color = fg;
+	g_bg_color = bg;
+	dropCommands();
+}
+
+static void dropCommands()
+{
+	g_cmd_count = 0;
+	g_cmd_used = 0;
+}
+
+static void flushCommands()
+{
+	if (g_cmd_count == 0)
+		return;
+	LOCK_LOG();
+	submitCommands();
+	UNLOCK_LOG();
+}
+
+static DrawCommand *newCommand(int len)
+{
+	DrawCommand *cmd;
+
+	if (g_cmd_count == CMD_MAX || g_cmd_used + len + 1 > CMD_TEXT)
+		flushCommands();
+
+	cmd = &g_cmds[g_cmd_count++];
+	cmd->fg = g_fg_color;
+	cmd->bg = g_bg_color;
+	cmd->start = g_cmd_used;
+	cmd->len = 0;
+	cmd->x = cmd->y = NULL;
+	return cmd;
+}
+
+static void queueText(const char *text, int len)
+{
+	DrawCommand *cmd = g_cmd_count ? &g_cmds[g_cmd_count - 1] : NULL;
+
+	g_stats.prints++;
+
+	if (!g_in_frame || len >= CMD_TEXT) {
+		flushCommands();
+		LOCK_LOG();
+		printTextScreen(text);
+		g_stats.runs++;
+		UNLOCK_LOG();
+		return;
+	}
+
+	if (!cmd || cmd->x || cmd->fg != g_fg_color || cmd->bg != g_bg_color ||
+			g_cmd_used + len > CMD_TEXT) {
+		cmd = newCommand(len);
+	}
+
+	memcpy(g_cmd_text + cmd->start + cmd->len, text, len);
+	cmd->len += len;
+	g_cmd_text[cmd->start + cmd->len] = '\0';
+	g_cmd_used = cmd->start + cmd->len + 1;
+}
+
+void psvDebugScreenFlush() {
+	flushCommands();
+}
+
+void psvDebugScreenMarkXY(int *x, int *y) {
+	DrawCommand *cmd;
+
+	if (!g_in_frame) {
+		flushCommands();
+		*x = gX;
+		*y = gY;
+		return;
+	}
+	cmd = newCommand(0);
+	cmd->x = x;
+	cmd->y = y;
 }
 
 void psvDebugScreenPrintf(const char *format, ...) {
 	char buf[1024];
+	int len;
+
+	va_list opt;
+	va_start(opt, format);
+	len = vsnprintf(buf, sizeof(buf), format, opt);
+	va_end(opt);
 
-	sceKernelLockMutex(g_log_mutex, 1, NULL);
+	if (len < 0)
+		return;
+	queueText(buf, len < (int)sizeof(buf) ? len : (int)sizeof(buf) - 1);
+}
 
+int psvDebugScreenLog(Color color, const char *format, ...) {
 	va_list opt;
+	int ret;
+
 	va_start(opt, format);
-	vsnprintf(buf, sizeof(buf), format, opt);
-	printTextScreen(buf);
+	ret = logqPushV(color, format, opt);
 	va_end(opt);
+	return ret;
+}
 
-	sceKernelUnlockMutex(g_log_mutex, 1);
+int psvDebugScreenFlushLog() {
+	static unsigned reported_drops = 0;
+	char note[48];
+	LogRecord record;
+	unsigned dropped;
+	Color old;
+	int count = 0;
+
+	LOCK_LOG();
+	submitCommands();
+	old = g_fg_color;
+	while (logqPop(&record)) {
+		g_fg_color = record.color;
+		printTextScreen(record.text);
+		count++;
+	}
+
+	dropped = logqDropped();
+	if (dropped != reported_drops) {
+		snprintf(note, sizeof(note), "\n! %u log record(s) dropped", dropped - reported_drops);
+		g_fg_color = RED;
+		printTextScreen(note);
+		reported_drops = dropped;
+	}
+	g_fg_color = old;
+	UNLOCK_LOG();
+	return count;
 }
 
 Color psvDebugScreenSetFgColor(Color color) {
@@ -183,6 +1114,6 @@ Color psvDebugScreenSetBgColor(Color color) {
 
 void printf_color(const char *text, Color color) {
 	psvDebugScreenSetFgColor(color);
-	psvDebugScreenPrintf(text);
+	queueText(text, strlen(text));
 	psvDebugScreenSetFgColor(WHITE);
 }
\ No newline at end of file
@@ -4,29 +4,134 @@ typedef unsigned char u8;
 typedef unsigned u32;
 typedef u32 Color;
 
-// allocates memory for framebuffer and initializes it
-void psvDebugScreenInit();
+// where the framebuffer lives and how it reaches the display
+typedef struct {
+	// returns a block of at least `size` bytes usable as A8B8G8R8 pixels
+	void *(*alloc)(unsigned size);
+	void (*free)(void *base);
+	// points the display at `base` (pitch and width are in pixels)
+	void (*set_display)(void *base, int pitch, int width, int height);
+	// blocks until the last set_display buffer is on screen
+	void (*wait_vblank)(void);
+} PsvFramebufferBackend;
+
+// sceDisplay backed on the Vita, plain heap memory everywhere else
+extern const PsvFramebufferBackend psvDefaultFramebufferBackend;
+
+// renderer counters, used by the host benchmark
+typedef struct {
+	unsigned long long glyphs;
+	unsigned long long clears;
+	unsigned long long frames;
+	unsigned long long scrolls;
+	unsigned long long bytes_written;
+	unsigned long long prints;	// printf and printf_color calls
+	unsigned long long runs;	// text runs laid out, prints after merging
+} PsvDebugScreenStats;
+
+// allocates memory for a front and a back framebuffer and initializes them;
+// returns < 0 if the backend has no memory for them, text is then still
+// kept but nothing is drawn
+int psvDebugScreenInit();
+
+// same as psvDebugScreenInit, but on a caller supplied backend
+int psvDebugScreenInitBackend(const PsvFramebufferBackend *backend);
+
+// releases the framebuffer through the backend
+void psvDebugScreenTerm();
+
+// Text lives in a grid of 8x9 character cells and is rasterized lazily:
+// only cells whose character or colors changed since a buffer last showed
+// them are redrawn. Everything drawn between these two goes to the back
+// buffer and is shown at once on the next vblank. Outside a frame text is
+// rasterized straight into the visible buffer after every print.
+void psvDebugScreenBeginFrame();
+void psvDebugScreenEndFrame();
 
 // clears screen with a given color
 void psvDebugScreenClear(int bg_color);
 
-// printf to the screen
+// fills a rectangle, clipped to the screen; the cursor is left alone.
+// Inside a frame, fills last only for that frame: cells under them are
+// restored the next time their buffer is drawn unless filled again.
+void psvDebugScreenFillRect(int x, int y, int w, int h, Color color);
+
+// fills pixel rows [y, y + rows) across the full screen width
+void psvDebugScreenClearRows(int y, int rows, Color color);
+
+// Large print: text at scale 1 to 3 (8 * scale pixels high) with
+// proportional spacing, drawn at pixel x, y in the current colors. It is
+// an overlay like a fill and is clipped at the right edge of the screen.
+// Both return the width in pixels, 0 for a bad scale.
+int psvDebugScreenDrawText(int x, int y, int scale, const char *text);
+int psvDebugScreenTextWidth(int scale, const char *text);
+
+// Text scrolls up once it reaches the bottom. The last `lines` lines that
+// scrolled off are kept for psvDebugScreenScrollBack (default 128).
+int psvDebugScreenSetScrollback(int lines);
+
+// shows the console `lines` lines back into history, 0 is the live end;
+// returns the offset actually shown, printing jumps back to the live end
+int psvDebugScreenScrollBack(int lines);
+
+// Makes the console a page of `rows` lines (at least one screen), which
+// text fills before it scrolls; clears the console and its history.
+// Cursor positions are then page positions, and the screen is a view onto
+// the page. Returns the rows or < 0 if they don't fit in memory.
+int psvDebugScreenSetPageRows(int rows);
+
+// shows the page from pixel row y down, clamped to the text printed since
+// the last clear; returns the y actually shown, snapped to a text row.
+// Only rows that come into view are drawn.
+int psvDebugScreenSetView(int y);
+int psvDebugScreenGetView();
+
+// Text is UTF-8. ASCII uses the built-in font, anything else is looked up
+// in an 8x8 font file (see fontfile.h) and shows as '?' when missing.
+// Returns < 0 if the file can't be used, non-ASCII then shows as '?'.
+int psvDebugScreenLoadFont(const char *path);
+
+// printf to the screen, from the thread that owns it
 void psvDebugScreenPrintf(const char *format, ...);
 
+// printf for every other thread: formats into a lock-free queue (see
+// logq.h) and returns without touching the screen, -1 if the record was
+// dropped. The owning thread prints what is queued with FlushLog and gets
+// the number of records back.
+int psvDebugScreenLog(Color color, const char *format, ...);
+int psvDebugScreenFlushLog();
+
 // set foreground (text) color
 Color psvDebugScreenSetFgColor(Color color);
 
 // set background color
 Color psvDebugScreenSetBgColor(Color color);
 
-// printf to the screen with color
+// prints text as is, in color, then switches back to white
 void printf_color(const char *text, Color color);
 
 void *psvDebugScreenGetVram();
 int psvDebugScreenGetX();
 int psvDebugScreenGetY();
+// positions are in pixels and snap to the character grid when printing
 void psvDebugScreenSetXY();
 
+// Inside a frame text is queued until the frame ends, and GetX/GetY have
+// to lay it out first. This stores the cursor as it will be after the
+// text printed so far instead, once that is laid out: at the latest when
+// the frame ends, right away outside a frame.
+void psvDebugScreenMarkXY(int *x, int *y);
+
+// lays out the text queued so far, which also fills in pending marks
+void psvDebugScreenFlush();
+
+int psvDebugScreenGetWidth();
+int psvDebugScreenGetHeight();
+int psvDebugScreenGetPitch();
+
+void psvDebugScreenGetStats(PsvDebugScreenStats *stats);
+void psvDebugScreenResetStats();
+
 enum {
 	RED     = 0xFF0000FF,
 	GREEN   = 0xFF00FF00,
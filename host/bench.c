@@ -0,0 +1,525 @@
+/*
+ * Host side renderer benchmark.
+ *
+ * Runs graphics.c against the plain memory framebuffer backend, reports
+ * throughput and bytes written per scene, dumps each final frame as PPM and
+ * compares a hash of it against host/golden.txt so renderer changes can be
+ * checked for pixel-identical output.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../graphics.h"
+
+typedef struct {
+	const char *name;
+	int iterations;
+	void (*run)(int iterations);
+} Scene;
+
+static double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/****************************** scenes ****************************************/
+
+// 60 lines of 120 printable characters, exactly one screen
+static void sceneText(int iterations)
+{
+	char line[121];
+	int it, y, x;
+
+	for (it = 0; it < iterations; it++) {
+		psvDebugScreenSetXY(0, 0);
+		for (y = 0; y < 60; y++) {
+			for (x = 0; x < 120; x++)
+				line[x] = ' ' + (x + y) % 95;
+			line[120] = '\0';
+			psvDebugScreenPrintf("%s", line);
+		}
+	}
+}
+
+static void sceneClear(int iterations)
+{
+	int it;
+
+	for (it = 0; it < iterations; it++)
+		psvDebugScreenClear((iterations - it) & 1 ? BLACK : 0xFF202020);
+}
+
+// roughly what main() prints, colors and all
+static void sceneReport(int iterations)
+{
+	int it;
+
+	for (it = 0; it < iterations; it++) {
+		psvDebugScreenClear(BLACK);
+		printf_color("PSVident v0.29\n\n\n", GREEN);
+		psvDebugScreenPrintf("* Vita model:           %s (0x%08X)\n", "Vita Slim", 0x10000);
+		psvDebugScreenPrintf("* Kernel version:       %s %s\n\n", "3.60 HENkaku v6", "CEX");
+		psvDebugScreenPrintf("* MAC address:          %s\n\n", "00:11:22:33:44:55");
+		psvDebugScreenPrintf("* IDPS:                 %s\n\n", "00000001010200140C00000000000000");
+		printf_color("* ", GREY);
+		psvDebugScreenPrintf("MemoryCard:           %s / %s\n", "12.40 GB", "29.71 GB");
+		psvDebugScreenPrintf("\n\nProcessor(s)\n\n");
+		printf_color("* ", YELLOW);
+		psvDebugScreenPrintf("ARM Clock frequency:  %d MHz\n", 444);
+		printf_color("* ", YELLOW);
+		psvDebugScreenPrintf("BUS Clock frequency:  %d MHz\n", 222);
+		psvDebugScreenPrintf("\n\nBattery\n\n");
+		printf_color("* ", RED);
+		psvDebugScreenPrintf("Battery percentage:   %s\n", "87%");
+		printf_color("* ", RED);
+		psvDebugScreenPrintf("Battery capacity:     %i/%i mAh\n", 1898, 2180);
+		printf_color("* ", RED);
+		psvDebugScreenPrintf("Battery voltage:      %s Volt\n", "4.08");
+		psvDebugScreenPrintf("\n\nRegistry/Settings\n\n");
+		printf_color("* ", CYAN);
+		psvDebugScreenPrintf("language:             %s\n", "English UK");
+		psvDebugScreenPrintf("\n\nPSN Account\n\n");
+		printf_color("* ", GREEN);
+		psvDebugScreenPrintf("PSN Nickname:         %s\n", "someone");
+	}
+}
+
+// the report as main.c prints it: bullet, label, a mark for the live
+// refresh, value and spacing as separate prints, one frame per iteration
+static void sceneFields(int iterations)
+{
+	static const struct {
+		const char *label, *value;
+		Color color;
+		int spacing;
+	} fields[] = {
+		{ "Vita model:",          "Vita Slim (0x00010000)", WHITE,  0 },
+		{ "Kernel version:",      "3.60 HENkaku v6 CEX",    WHITE,  1 },
+		{ "MAC address:",         "00:11:22:33:44:55",      WHITE,  1 },
+		{ "IDPS:",                "00000001010200140C00000000000000", WHITE, 1 },
+		{ "MemoryCard:",          "12.40 GB / 29.71 GB",    GREY,   0 },
+		{ "ARM Clock frequency:", "444 MHz",                YELLOW, 0 },
+		{ "BUS Clock frequency:", "222 MHz",                YELLOW, 0 },
+		{ "Battery percentage:",  "87%",                    RED,    0 },
+		{ "Battery capacity:",    "1898/2180 mAh",          RED,    0 },
+		{ "Battery status:",      "Charging",               RED,    0 },
+		{ "Battery voltage:",     "4.08 Volt",              RED,    0 },
+		{ "language:",            "English UK",             CYAN,   0 },
+		{ "PSN Nickname:",        "someone",                GREEN,  0 },
+		{ "account_id:",          "0123456789ABCDEF",       GREEN,  0 },
+	};
+	static int x[14], y[14];
+	int it, i, j;
+
+	for (it = 0; it < iterations; it++) {
+		psvDebugScreenBeginFrame();
+		psvDebugScreenClear(BLACK);
+		printf_color("PSVident v0.30\n\n\n", GREEN);
+		for (i = 0; i < 14; i++) {
+			if (i == 5 || i == 7 || i == 11 || i == 12)
+				psvDebugScreenPrintf("\n\n%s\n\n", i == 5 ? "Processor(s)" : i == 7 ? "Battery" :
+					i == 11 ? "Registry/Settings" : "PSN Account");
+			printf_color("* ", fields[i].color);
+			psvDebugScreenPrintf("%-22s", fields[i].label);
+			psvDebugScreenMarkXY(&x[i], &y[i]);
+			psvDebugScreenPrintf("%-*s", 0, fields[i].value);
+			psvDebugScreenPrintf("\n");
+			for (j = 0; j < fields[i].spacing; j++)
+				psvDebugScreenPrintf("\n");
+		}
+		psvDebugScreenPrintf("\n\n\n> Press Select + Start to exit..");
+		psvDebugScreenEndFrame();
+	}
+}
+
+// long output that wraps past the bottom of the screen
+static void sceneWrap(int iterations)
+{
+	int it, i;
+
+	for (it = 0; it < iterations; it++) {
+		psvDebugScreenClear(BLACK);
+		for (i = 0; i < 100; i++)
+			psvDebugScreenPrintf("line %3d: the quick brown fox jumps over the lazy dog\n", i);
+	}
+}
+
+// a 12x8 checkerboard of rectangles, the kind of partial redraw a refresh does
+static void sceneRect(int iterations)
+{
+	int it, x, y;
+
+	for (it = 0; it < iterations; it++)
+		for (y = 0; y < 8; y++)
+			for (x = 0; x < 12; x++)
+				psvDebugScreenFillRect(x * 80, y * 68, 80, 68,
+					(x + y) & 1 ? 0xFF404040 : 0xFF000080);
+}
+
+// redraws alternating 9 pixel text rows
+static void sceneRows(int iterations)
+{
+	int it, y;
+
+	for (it = 0; it < iterations; it++)
+		for (y = 0; y + 9 <= 544; y += 18)
+			psvDebugScreenClearRows(y, 9, 0xFF202020);
+}
+
+// the report drawn into the back buffer and presented as one frame
+static void sceneFrame(int iterations)
+{
+	int it;
+
+	for (it = 0; it < iterations; it++) {
+		psvDebugScreenBeginFrame();
+		sceneReport(1);
+		psvDebugScreenEndFrame();
+	}
+}
+
+// a long log, then a look 30 lines back into the scrollback
+static void sceneScroll(int iterations)
+{
+	int it, i;
+
+	for (it = 0; it < iterations; it++) {
+		psvDebugScreenClear(BLACK);
+		for (i = 0; i < 1000; i++) {
+			psvDebugScreenSetFgColor(i & 1 ? WHITE : AZURE);
+			psvDebugScreenPrintf("entry %4d: scrolling console\n", i);
+		}
+		psvDebugScreenScrollBack(30);
+	}
+	psvDebugScreenSetFgColor(WHITE);
+}
+
+// the report once, then frames that only rewrite the battery values
+static void sceneUpdate(int iterations)
+{
+	int it, x, y;
+
+	psvDebugScreenBeginFrame();
+	sceneReport(1);
+	psvDebugScreenPrintf("\n\n* Battery percentage:   ");
+	x = psvDebugScreenGetX();
+	y = psvDebugScreenGetY();
+	psvDebugScreenPrintf("100%%\n");
+	psvDebugScreenEndFrame();
+
+	// counts down so the last frame is the same for every iteration count
+	for (it = iterations - 1; it >= 0; it--) {
+		psvDebugScreenBeginFrame();
+		psvDebugScreenSetXY(x, y);
+		psvDebugScreenPrintf("%3d%%  %d.%02d Volt  %d minutes ", 100 - it % 100,
+			3 + it % 2, it % 100, 300 - it % 300);
+		psvDebugScreenEndFrame();
+	}
+}
+
+// report lines in large print at 2x and a 3x title, one frame each
+static void sceneLarge(int iterations)
+{
+	static const char *lines[] = {
+		"Vita model:  Vita Slim (0x10000)",
+		"Kernel version:  3.60 HENkaku v6 CEX",
+		"MAC address:  00:11:22:33:44:55",
+		"IDPS:  00000001010200140C00000000000000",
+		"MemoryCard:  12.40 GB / 29.71 GB",
+		"Battery percentage:  87%",
+		"Battery voltage:  4.08 Volt",
+		"language:  English UK",
+	};
+	int it, i;
+
+	for (it = 0; it < iterations; it++) {
+		psvDebugScreenBeginFrame();
+		psvDebugScreenSetFgColor(GREEN);
+		psvDebugScreenDrawText(16, 8, 3, "PSVident v0.30");
+		psvDebugScreenSetFgColor(WHITE);
+		for (i = 0; i < 8; i++)
+			psvDebugScreenDrawText(16, 48 + i * 20, 2, lines[i]);
+		psvDebugScreenEndFrame();
+	}
+}
+
+// Cyrillic, kana and kanji from a generated font file, one screen per
+// iteration; compare glyphs/s with "text"
+static void sceneUtf8(int iterations)
+{
+	static const char *words[] = {
+		"3.60 )(\xe5\xa4\x89\xe9\x9d\xa9-6 ",	// HENkaku's 変革
+		"\xd0\x9f\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82 ",	// Привет
+		"\xe3\x83\x90\xe3\x83\x83\xe3\x83\x86\xe3\x83\xaa\xe3\x83\xbc ",	// バッテリー
+		"\xe8\xa8\x80\xe8\xaa\x9e ",	// 言語
+		"bad \xff\xc0\xaf ",
+	};
+	char line[512];
+	int it, y, i;
+
+	for (it = 0; it < iterations; it++) {
+		psvDebugScreenSetXY(0, 0);
+		for (y = 0; y < 60; y++) {
+			line[0] = '\0';
+			for (i = 0; i < 12; i++)
+				strcat(line, words[(y + i) % 5]);
+			psvDebugScreenPrintf("%s\n", line);
+		}
+	}
+}
+
+// a 200 line page viewed one line further down each frame; the cost per
+// frame is one screen of moved pixels and one new row, whatever the length
+static void scenePage(int iterations)
+{
+	int it, i;
+
+	psvDebugScreenSetPageRows(240);
+	psvDebugScreenBeginFrame();
+	for (i = 0; i < 200; i++) {
+		psvDebugScreenSetFgColor(i % 3 ? WHITE : CYAN);
+		psvDebugScreenPrintf("* row %3d of a page taller than the screen\n", i);
+	}
+	psvDebugScreenEndFrame();
+
+	// counts down so the last frame is the same for every iteration count
+	for (it = iterations - 1; it >= 0; it--) {
+		psvDebugScreenBeginFrame();
+		psvDebugScreenSetView(it % 141 * 9);
+		psvDebugScreenEndFrame();
+	}
+}
+
+static const Scene scenes[] = {
+	{ "text",   200, sceneText },
+	{ "clear",  500, sceneClear },
+	{ "report", 500, sceneReport },
+	{ "wrap",   100, sceneWrap },
+	{ "rect",   500, sceneRect },
+	{ "rows",   500, sceneRows },
+	{ "frame",  500, sceneFrame },
+	{ "fields", 500, sceneFields },
+	{ "scroll",  10, sceneScroll },
+	{ "update", 500, sceneUpdate },
+	{ "large",  500, sceneLarge },
+	{ "utf8",   200, sceneUtf8 },
+	{ "page",   500, scenePage },
+};
+
+/****************************** output ****************************************/
+
+static unsigned long long hashFrame()
+{
+	const u32 *vram = psvDebugScreenGetVram();
+	int pitch = psvDebugScreenGetPitch();
+	unsigned long long hash = 0xcbf29ce484222325ULL;
+	int x, y;
+
+	for (y = 0; y < psvDebugScreenGetHeight(); y++) {
+		for (x = 0; x < psvDebugScreenGetWidth(); x++) {
+			u32 pixel = vram[y * pitch + x];
+			int b;
+			for (b = 0; b < 4; b++) {
+				hash ^= (pixel >> (b * 8)) & 0xFF;
+				hash *= 0x100000001b3ULL;
+			}
+		}
+	}
+	return hash;
+}
+
+static int writePPM(const char *path)
+{
+	const u32 *vram = psvDebugScreenGetVram();
+	int pitch = psvDebugScreenGetPitch();
+	int width = psvDebugScreenGetWidth();
+	int height = psvDebugScreenGetHeight();
+	unsigned char *row;
+	FILE *fp;
+	int x, y;
+
+	if ((fp = fopen(path, "wb")) == NULL)
+		return -1;
+
+	row = malloc(width * 3);
+	fprintf(fp, "P6\n%d %d\n255\n", width, height);
+	for (y = 0; y < height; y++) {
+		for (x = 0; x < width; x++) {
+			u32 pixel = vram[y * pitch + x]; // A8B8G8R8
+			row[x * 3 + 0] = pixel & 0xFF;
+			row[x * 3 + 1] = (pixel >> 8) & 0xFF;
+			row[x * 3 + 2] = (pixel >> 16) & 0xFF;
+		}
+		fwrite(row, 3, width, fp);
+	}
+	free(row);
+	fclose(fp);
+	return 0;
+}
+
+// a stand-in for resource/unicode8.fnt: every codepoint the utf8 scene
+// uses plus 2048 kanji, each glyph a pattern derived from its codepoint
+static int writeTestFont(const char *path)
+{
+	static const unsigned ranges[][2] = {
+		{ 0x0400, 0x04FF }, { 0x3040, 0x30FF }, { 0x4E00, 0x55FF },
+		{ 0x5909, 0x5909 }, { 0x8A00, 0x8AFF }, { 0x9769, 0x9769 },
+	};
+	unsigned char header[12] = { 'P', 'S', 'V', 'F', 1, 0, 8, 8 };
+	unsigned count = 0, cp, r, i;
+	FILE *fp = fopen(path, "wb");
+
+	if (fp == NULL)
+		return -1;
+	for (r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++)
+		count += ranges[r][1] - ranges[r][0] + 1;
+	header[8] = count;
+	header[9] = count >> 8;
+	fwrite(header, 1, sizeof(header), fp);
+
+	for (r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++) {
+		for (cp = ranges[r][0]; cp <= ranges[r][1]; cp++) {
+			fputc(cp & 0xFF, fp);
+			fputc(cp >> 8, fp);
+		}
+	}
+	for (r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++) {
+		for (cp = ranges[r][0]; cp <= ranges[r][1]; cp++) {
+			for (i = 0; i < 8; i++)
+				fputc(i == 0 || i == 7 ? 0x7E : 0x42 | ((cp >> i) & 1) << 4 | ((cp >> (i + 8)) & 1) << 3, fp);
+		}
+	}
+	return fclose(fp);
+}
+
+static int lookupGolden(const char *path, const char *name, unsigned long long *hash)
+{
+	char scene[64];
+	unsigned long long value;
+	FILE *fp;
+
+	if ((fp = fopen(path, "r")) == NULL)
+		return -1;
+
+	while (fscanf(fp, "%63s %llx", scene, &value) == 2) {
+		if (strcmp(scene, name) == 0) {
+			*hash = value;
+			fclose(fp);
+			return 0;
+		}
+	}
+	fclose(fp);
+	return -1;
+}
+
+static void usage()
+{
+	fprintf(stderr,
+		"usage: psvbench [-o dir] [-g golden.txt] [-w golden.txt] [-n scale]\n"
+		"  -o dir    dump the final frame of every scene to dir/<scene>.ppm\n"
+		"  -g file   compare frame hashes against file, fail on mismatch\n"
+		"  -w file   write frame hashes to file\n"
+		"  -n scale  multiply iteration counts (0 runs each scene once)\n");
+}
+
+int main(int argc, char *argv[])
+{
+	const char *out_dir = NULL, *check = NULL, *update = NULL;
+	FILE *golden_out = NULL;
+	double scale = 1.0;
+	int failed = 0;
+	unsigned i;
+
+	for (i = 1; i < (unsigned)argc; i++) {
+		if (strcmp(argv[i], "-o") == 0 && i + 1 < (unsigned)argc)
+			out_dir = argv[++i];
+		else if (strcmp(argv[i], "-g") == 0 && i + 1 < (unsigned)argc)
+			check = argv[++i];
+		else if (strcmp(argv[i], "-w") == 0 && i + 1 < (unsigned)argc)
+			update = argv[++i];
+		else if (strcmp(argv[i], "-n") == 0 && i + 1 < (unsigned)argc)
+			scale = atof(argv[++i]);
+		else {
+			usage();
+			return 2;
+		}
+	}
+
+	if (update && (golden_out = fopen(update, "w")) == NULL) {
+		perror(update);
+		return 2;
+	}
+
+	psvDebugScreenInit();
+	if (writeTestFont("psvbench.fnt") < 0 || psvDebugScreenLoadFont("psvbench.fnt") < 0)
+		fprintf(stderr, "could not set up the test font, utf8 will show '?'\n");
+
+	printf("%-8s %8s %10s %12s %10s %10s %10s %10s %9s %9s %12s  %s\n",
+		"scene", "iters", "ms", "glyphs/s", "clears/s", "frames/s", "glyphs/frm", "us/scroll",
+		"prints/it", "runs/it", "MB written", "hash");
+
+	for (i = 0; i < sizeof(scenes) / sizeof(scenes[0]); i++) {
+		const Scene *scene = &scenes[i];
+		PsvDebugScreenStats stats;
+		unsigned long long hash, expected;
+		int iterations = scene->iterations * scale;
+		double start, elapsed;
+
+		if (iterations < 1)
+			iterations = 1;
+
+		psvDebugScreenSetFgColor(WHITE);
+		psvDebugScreenSetBgColor(BLACK);
+		psvDebugScreenSetPageRows(0);
+		psvDebugScreenClear(BLACK);
+		psvDebugScreenResetStats();
+
+		start = now();
+		scene->run(iterations);
+		elapsed = now() - start;
+
+		psvDebugScreenGetStats(&stats);
+		hash = hashFrame();
+
+		printf("%-8s %8d %10.2f %12.0f %10.1f %10.1f %10.1f %10.2f %9.1f %9.1f %12.1f  %016llx",
+			scene->name, iterations, elapsed * 1e3,
+			stats.glyphs / elapsed, stats.clears / elapsed, stats.frames / elapsed,
+			stats.frames ? (double)stats.glyphs / stats.frames : 0.0,
+			stats.scrolls ? elapsed * 1e6 / stats.scrolls : 0.0,
+			(double)stats.prints / iterations, (double)stats.runs / iterations,
+			stats.bytes_written / (1024.0 * 1024.0), hash);
+
+		if (check) {
+			if (lookupGolden(check, scene->name, &expected) < 0) {
+				printf("  (no golden)");
+			} else if (expected != hash) {
+				printf("  MISMATCH (golden %016llx)", expected);
+				failed = 1;
+			} else {
+				printf("  ok");
+			}
+		}
+		printf("\n");
+
+		if (golden_out)
+			fprintf(golden_out, "%s %016llx\n", scene->name, hash);
+
+		if (out_dir) {
+			char path[512];
+			snprintf(path, sizeof(path), "%s/%s.ppm", out_dir, scene->name);
+			if (writePPM(path) < 0)
+				fprintf(stderr, "could not write %s\n", path);
+		}
+	}
+
+	if (golden_out)
+		fclose(golden_out);
+	psvDebugScreenTerm();
+	remove("psvbench.fnt");
+	return failed;
+}
@@ -0,0 +1,158 @@
+/*
+ * Host side formatter benchmark.
+ *
+ * Times fmt.c against the sprintf/float/atoi paths sysinfo.c used before
+ * (kept here as the reference) over a sweep of realistic inputs, and counts
+ * outputs that differ. printf rounds the binary value: voltage went through
+ * a float, so x.xx5 often printed low, and exact halves in sizes round to
+ * even. Those differ in the last digit by design; anything more is a bug.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../fmt.h"
+
+#define INPUTS 4096
+
+static double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int values[INPUTS];
+static uint64_t sizes[INPUTS];
+static unsigned char ids[INPUTS][16];
+
+/****************************** old paths ****************************************/
+
+static void oldVoltage(char *out, int mv)     { sprintf(out, "%0.2f", (float)mv / 1000.0); }
+static void oldCelsius(char *out, int t)      { sprintf(out, "%0.2f", (float)t / 100.0); }
+static void oldFahrenheit(char *out, int t)   { sprintf(out, "%0.2f", (1.8 * (float)t / 100.0) + 32); }
+
+static void oldCapacity(char *out, int mah)
+{
+	char mAh[10];
+	sprintf(mAh, "%i", mah);
+	sprintf(out, "%i", atoi(mAh));
+}
+
+static void oldCID(char *out, const unsigned char *id)
+{
+	int i;
+	for (i = 0; i < 16; i++)
+		sprintf(out + i * 2, "%02X", id[i]);
+}
+
+static void oldMac(char *out, const unsigned char *m)
+{
+	sprintf(out, "%02X:%02X:%02X:%02X:%02X:%02X", m[0], m[1], m[2], m[3], m[4], m[5]);
+}
+
+static void oldSize(char *string, uint64_t size)
+{
+	double double_size = (double)size;
+	int i = 0;
+	static char *units[] = { "B", "KB", "MB", "GB", "TB", "PB", "EB", "ZB", "YB" };
+	while (double_size >= 1024.0f) {
+		double_size /= 1024.0f;
+		i++;
+	}
+	sprintf(string, "%.*f %s", (i == 0) ? 0 : 2, double_size, units[i]);
+}
+
+/****************************** new paths ****************************************/
+
+static void newVoltage(char *out, int mv)     { fmtFixed(out, mv, 3, 2); }
+static void newCelsius(char *out, int t)      { fmtFixed(out, t, 2, 2); }
+static void newFahrenheit(char *out, int t)   { fmtFixed(out, t * 18 + 32000, 3, 2); }
+static void newCapacity(char *out, int mah)   { fmtInt(out, mah); }
+static void newCID(char *out, const unsigned char *id) { fmtHexBytes(out, id, 16); }
+static void newMac(char *out, const unsigned char *m)  { fmtMac(out, m); }
+static void newSize(char *out, uint64_t size) { fmtSize(out, size); }
+
+/****************************** cases ****************************************/
+
+typedef struct {
+	const char *name;
+	void (*old_int)(char *, int);
+	void (*new_int)(char *, int);
+	void (*old_bytes)(char *, const unsigned char *);
+	void (*new_bytes)(char *, const unsigned char *);
+	void (*old_size)(char *, uint64_t);
+	void (*new_size)(char *, uint64_t);
+} Case;
+
+static const Case cases[] = {
+	{ "voltage",    oldVoltage,    newVoltage },
+	{ "celsius",    oldCelsius,    newCelsius },
+	{ "fahrenheit", oldFahrenheit, newFahrenheit },
+	{ "capacity",   oldCapacity,   newCapacity },
+	{ "cid",        NULL, NULL, oldCID, newCID },
+	{ "mac",        NULL, NULL, oldMac, newMac },
+	{ "size",       NULL, NULL, NULL, NULL, oldSize, newSize },
+};
+
+static void run(const Case *c, int use_old, int i, char *out)
+{
+	if (c->old_int)
+		(use_old ? c->old_int : c->new_int)(out, values[i]);
+	else if (c->old_bytes)
+		(use_old ? c->old_bytes : c->new_bytes)(out, ids[i]);
+	else
+		(use_old ? c->old_size : c->new_size)(out, sizes[i]);
+}
+
+int main(int argc, char *argv[])
+{
+	int rounds = argc > 1 ? atoi(argv[1]) : 200;
+	char a[64], b[64];
+	double start, old_time, new_time;
+	unsigned c, i, r, diffs;
+	volatile char sink = 0;
+
+	srand(1);
+	for (i = 0; i < INPUTS; i++) {
+		values[i] = 2000 + rand() % 5000;	// mV, 1/100 C and mAh all land here
+		sizes[i] = ((uint64_t)rand() << 20 | rand()) >> (rand() % 40);
+		for (r = 0; r < 16; r++)
+			ids[i][r] = rand();
+	}
+
+	printf("%-12s %10s %10s %8s %8s\n", "case", "old ns", "new ns", "speedup", "differ");
+
+	for (c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+		diffs = 0;
+		for (i = 0; i < INPUTS; i++) {
+			run(&cases[c], 1, i, a);
+			run(&cases[c], 0, i, b);
+			diffs += strcmp(a, b) != 0;
+		}
+
+		start = now();
+		for (r = 0; r < rounds; r++)
+			for (i = 0; i < INPUTS; i++) {
+				run(&cases[c], 1, i, a);
+				sink += a[0];
+			}
+		old_time = now() - start;
+
+		start = now();
+		for (r = 0; r < rounds; r++)
+			for (i = 0; i < INPUTS; i++) {
+				run(&cases[c], 0, i, b);
+				sink += b[0];
+			}
+		new_time = now() - start;
+
+		printf("%-12s %10.1f %10.1f %7.1fx %8u\n", cases[c].name,
+			old_time * 1e9 / rounds / INPUTS, new_time * 1e9 / rounds / INPUTS,
+			old_time / new_time, diffs);
+	}
+	return sink == 1;
+}
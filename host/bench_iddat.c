@@ -0,0 +1,165 @@
+/*
+ * Host side id.dat parser benchmark.
+ *
+ * Times the single-pass parser in iddat.c against the fscanf/strstr/strtok
+ * chain it replaced (kept here verbatim as the reference), both parsing the
+ * same id.dat from memory, and checks they agree on the fields PSVident shows.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../iddat.h"
+
+static const char sample[] =
+	"MID=00000000000000000000000000000000\n"
+	"DIG=4f6e65546f756368\n"
+	"DID=00000001010200140c00000000000000\n"
+	"AID=9a2c3f1e7b5d4c80\n"
+	"OID=SomeNickname\n"
+	"SVR=3.600\n";
+
+// indented keys, which fscanf("%s") skipped over
+static const char indented[] =
+	"  MID=00000000000000000000000000000000\r\n"
+	"\tDIG=4f6e65546f756368\r\n"
+	" \tDID=00000001010200140c00000000000000\n"
+	"   AID=9a2c3f1e7b5d4c80 \n"
+	"\t\tOID=OtherNickname\n"
+	" SVR=3.650\n";
+
+static double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/****************************** old parser ****************************************/
+
+static char buff[255];
+static char mid[50], dig[50], did[50], aid[50], oid[255], svr[50];
+
+// strncpy as the old parser did it, but always terminated
+#define COPY_VALUE(dst, src) \
+	(strncpy(dst, src, sizeof(dst) - 1), dst[sizeof(dst) - 1] = '\0')
+
+static int convert_dat(char* buff)
+{
+	char delimiter[] = "=";
+	char *ptr;
+
+	if(strstr(buff, "MID=")) {
+		ptr = strtok(buff, delimiter);
+		ptr = strtok(NULL, delimiter);
+		COPY_VALUE(mid, ptr);
+	} else if(strstr(buff, "DIG=")) {
+		ptr = strtok(buff, delimiter);
+		ptr = strtok(NULL, delimiter);
+		COPY_VALUE(dig, ptr);
+	} else if(strstr(buff, "DID=")) {
+		ptr = strtok(buff, delimiter);
+		ptr = strtok(NULL, delimiter);
+		COPY_VALUE(did, ptr);
+	} else if(strstr(buff, "AID=")) {
+		ptr = strtok(buff, delimiter);
+		ptr = strtok(NULL, delimiter);
+		COPY_VALUE(aid, ptr);
+	} else if(strstr(buff, "OID=")) {
+		ptr = strtok(buff, delimiter);
+		ptr = strtok(NULL, delimiter);
+		COPY_VALUE(oid, ptr);
+	} else if(strstr(buff, "SVR=")) {
+		ptr = strtok(buff, delimiter);
+		ptr = strtok(NULL, delimiter);
+		COPY_VALUE(svr, ptr);
+	} else {
+		return 1;
+	}
+	return 0;
+}
+
+static int oldParse(const char *data, size_t size)
+{
+	FILE *f1 = fmemopen((void *)data, size, "r");
+	int ret = 0;
+
+	while (fscanf(f1, "%s", buff) == 1)
+		ret |= convert_dat(buff);
+	fclose(f1);
+	return ret;
+}
+
+/****************************** new parser ****************************************/
+
+static char id_dat_buffer[IDDAT_MAX_SIZE];
+static IdDat id_dat;
+
+// the read into the buffer is what readIDDAT() does with fread
+static int newParse(const char *data, size_t size)
+{
+	memcpy(id_dat_buffer, data, size);
+	return idDatParse(&id_dat, id_dat_buffer, size);
+}
+
+// both parsers on the same input, 0 if they differ on a field or on
+// whether the file looked wrongly formatted
+static int agree(const char *data, size_t size)
+{
+	static const struct {
+		IdDatKey key;
+		const char *old_value;
+	} fields[] = {
+		{ IDDAT_MID, mid }, { IDDAT_DIG, dig }, { IDDAT_DID, did },
+		{ IDDAT_AID, aid }, { IDDAT_OID, oid }, { IDDAT_SVR, svr },
+	};
+	char value[255];
+	int i;
+
+	if (oldParse(data, size) != newParse(data, size))
+		return 0;
+	for (i = 0; i < (int)(sizeof(fields) / sizeof(fields[0])); i++) {
+		idDatCopy(&id_dat, fields[i].key, value, sizeof(value));
+		if (strcmp(value, fields[i].old_value) != 0)
+			return 0;
+	}
+	return 1;
+}
+
+int main(int argc, char *argv[])
+{
+	long iterations = argc > 1 ? atol(argv[1]) : 1000000, it;
+	double start, old_time, new_time;
+	volatile int sink = 0;
+
+	if (iterations < 1)
+		iterations = 1;
+
+	if (!agree(sample, sizeof(sample) - 1) || !agree(indented, sizeof(indented) - 1))
+		goto mismatch;
+
+	start = now();
+	for (it = 0; it < iterations; it++)
+		sink += oldParse(sample, sizeof(sample) - 1);
+	old_time = now() - start;
+
+	start = now();
+	for (it = 0; it < iterations; it++)
+		sink += newParse(sample, sizeof(sample) - 1);
+	new_time = now() - start;
+
+	printf("%-8s %10s %12s\n", "parser", "ns/parse", "MB/s");
+	printf("%-8s %10.1f %12.1f\n", "fscanf", old_time * 1e9 / iterations,
+		(sizeof(sample) - 1) * iterations / old_time / 1e6);
+	printf("%-8s %10.1f %12.1f\n", "iddat", new_time * 1e9 / iterations,
+		(sizeof(sample) - 1) * iterations / new_time / 1e6);
+	printf("speedup  %.1fx\n", old_time / new_time);
+	return sink != 0;
+
+mismatch:
+	fprintf(stderr, "parsers disagree\n");
+	return 1;
+}
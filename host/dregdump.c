@@ -0,0 +1,148 @@
+/*
+ * Host side system.dreg dump.
+ *
+ * Decodes a captured vd0:registry/system.dreg with dreg.c and prints every
+ * key the descriptor table knows, or just the ones asked for. -x shows raw
+ * bytes, -d lists the offsets where two captures differ, which is how new
+ * keys get located (change one setting on the Vita, capture, compare).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../dreg.h"
+
+static unsigned char *readFile(const char *path, int *size)
+{
+	unsigned char *data;
+	long len;
+	FILE *fp = fopen(path, "rb");
+
+	if (fp == NULL) {
+		perror(path);
+		return NULL;
+	}
+	fseek(fp, 0, SEEK_END);
+	len = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	data = malloc(len > 0 ? len : 1);
+	if (data == NULL || fread(data, 1, len, fp) != (size_t)len) {
+		perror(path);
+		free(data);
+		fclose(fp);
+		return NULL;
+	}
+	fclose(fp);
+	*size = len;
+	return data;
+}
+
+static void printKey(const Dreg *dreg, const DregKey *key)
+{
+	char string[256];
+	int val, ret, i;
+
+	printf("%-24s %-24s @%-6d ", key->category, key->name, key->offset);
+	switch (key->type) {
+	case DREG_INT:
+		ret = dregGetInt(dreg, key->category, key->name, &val);
+		if (ret == 0)
+			printf("int    %d\n", val);
+		break;
+	case DREG_STRING:
+		ret = dregGetString(dreg, key->category, key->name, string, sizeof(string));
+		if (ret == 0)
+			printf("string \"%s\"\n", string);
+		break;
+	default:
+		ret = key->offset + key->size > dreg->size ? DREG_ERROR_TRUNCATED : 0;
+		if (ret == 0) {
+			printf("binary");
+			for (i = 0; i < key->size; i++)
+				printf(" %02x", dreg->data[key->offset + i]);
+			printf("\n");
+		}
+		break;
+	}
+	if (ret < 0)
+		printf("error  %d\n", ret);
+}
+
+static void hexdump(const Dreg *dreg, int offset, int len)
+{
+	int i;
+
+	for (i = 0; i < len && offset + i < dreg->size; i++) {
+		if (i % 16 == 0)
+			printf(i ? "\n%08x " : "%08x ", offset + i);
+		printf(" %02x", dreg->data[offset + i]);
+	}
+	printf("\n");
+}
+
+static void usage()
+{
+	fprintf(stderr,
+		"usage: dregdump system.dreg [/CATEGORY/key]...\n"
+		"       dregdump system.dreg -x offset [length]\n"
+		"       dregdump system.dreg -d other.dreg\n");
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned char *data, *other;
+	int size, other_size, i;
+	const DregKey *key;
+	Dreg dreg;
+	char *slash;
+
+	if (argc < 2) {
+		usage();
+		return 2;
+	}
+	if ((data = readFile(argv[1], &size)) == NULL)
+		return 2;
+	dregInit(&dreg, data, size);
+	printf("%s: %d bytes\n", argv[1], size);
+
+	if (argc >= 4 && strcmp(argv[2], "-x") == 0) {
+		hexdump(&dreg, strtol(argv[3], NULL, 0), argc >= 5 ? strtol(argv[4], NULL, 0) : 64);
+		return 0;
+	}
+
+	if (argc >= 4 && strcmp(argv[2], "-d") == 0) {
+		if ((other = readFile(argv[3], &other_size)) == NULL)
+			return 2;
+		for (i = 0; i < size && i < other_size; i++) {
+			if (data[i] != other[i])
+				printf("%08x  %02x -> %02x\n", i, data[i], other[i]);
+		}
+		if (size != other_size)
+			printf("sizes differ: %d vs %d\n", size, other_size);
+		return 0;
+	}
+
+	if (argc == 2) {
+		for (i = 0; i < dreg_key_count; i++)
+			printKey(&dreg, &dreg_keys[i]);
+		return 0;
+	}
+
+	for (i = 2; i < argc; i++) {
+		// split "/CONFIG/SYSTEM/region_no" at the last slash
+		slash = strrchr(argv[i], '/');
+		if (slash == NULL || slash == argv[i]) {
+			usage();
+			return 2;
+		}
+		*slash = '\0';
+		key = dregFind(argv[i], slash + 1);
+		if (key == NULL)
+			printf("%s/%s: not in the descriptor table\n", argv[i], slash + 1);
+		else
+			printKey(&dreg, key);
+	}
+	return 0;
+}
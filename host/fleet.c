@@ -0,0 +1,592 @@
+/*
+ * Host side fleet inventory.
+ *
+ * Ingests the report.csv files PSVident exports (see export.c), one per
+ * unit, and indexes them by model, firmware, region and battery State of
+ * Health so questions like "all Slims under 80% SOH" can be answered
+ * straight away. Files are mmap'd and parsed on one thread per core.
+ * Can also write a synthetic corpus to benchmark ingest against.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define FIELD_SIZE 64
+#define NO_SOH -1	// PSTVs have no battery
+
+typedef struct {
+	char model[FIELD_SIZE];
+	char firmware[FIELD_SIZE];
+	char region[FIELD_SIZE];
+	int soh;
+	int ok;			// parsed, has at least a model
+} Report;
+
+// one dimension of the index: distinct values and the reports holding each
+typedef struct {
+	char **keys;
+	int key_count;
+	int *first;		// first[k]..first[k + 1] index into units
+	int *units;
+	int *key_of;	// key id of every report
+} Index;
+
+static char **paths;
+static int path_count, path_cap;
+static Report *reports;
+
+static double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *xmalloc(size_t size)
+{
+	void *p = malloc(size ? size : 1);
+
+	if (p == NULL) {
+		perror("malloc");
+		exit(2);
+	}
+	return p;
+}
+
+/****************************** file list ****************************************/
+
+static void addPath(const char *path)
+{
+	if (path_count == path_cap) {
+		path_cap = path_cap ? path_cap * 2 : 1024;
+		paths = realloc(paths, path_cap * sizeof(char *));
+		if (paths == NULL) {
+			perror("realloc");
+			exit(2);
+		}
+	}
+	paths[path_count++] = strdup(path);
+}
+
+static int hasSuffix(const char *name, const char *suffix)
+{
+	size_t len = strlen(name), slen = strlen(suffix);
+
+	return len >= slen && strcmp(name + len - slen, suffix) == 0;
+}
+
+// a directory contributes every *.csv directly inside it
+static void addArgument(const char *arg)
+{
+	char path[4096];
+	struct stat st;
+	struct dirent *entry;
+	DIR *dir;
+
+	if (stat(arg, &st) < 0) {
+		perror(arg);
+		return;
+	}
+	if (!S_ISDIR(st.st_mode)) {
+		addPath(arg);
+		return;
+	}
+
+	dir = opendir(arg);
+	if (dir == NULL) {
+		perror(arg);
+		return;
+	}
+	while ((entry = readdir(dir)) != NULL) {
+		if (!hasSuffix(entry->d_name, ".csv"))
+			continue;
+		snprintf(path, sizeof(path), "%s/%s", arg, entry->d_name);
+		addPath(path);
+	}
+	closedir(dir);
+}
+
+/****************************** parsing ****************************************/
+
+// copies one CSV field, quoted or not, and returns where the next one starts
+static const char *csvField(const char *p, const char *end, char *out, int size)
+{
+	int len = 0;
+
+	if (p < end && *p == '"') {
+		for (p++; p < end; p++) {
+			if (*p == '"') {
+				if (p + 1 < end && p[1] == '"')
+					p++;
+				else {
+					p++;
+					break;
+				}
+			}
+			if (len < size - 1)
+				out[len++] = *p;
+		}
+	} else {
+		for (; p < end && *p != ',' && *p != '\n' && *p != '\r'; p++) {
+			if (len < size - 1)
+				out[len++] = *p;
+		}
+	}
+	out[len] = '\0';
+
+	if (p < end && *p == ',')
+		p++;
+	return p;
+}
+
+static void parseReport(const char *p, const char *end, Report *report)
+{
+	char key[FIELD_SIZE], skip[FIELD_SIZE], value[FIELD_SIZE], error[16];
+
+	report->soh = NO_SOH;
+
+	while (p < end) {
+		p = csvField(p, end, key, sizeof(key));
+		p = csvField(p, end, skip, sizeof(skip));	// category
+		p = csvField(p, end, skip, sizeof(skip));	// label
+		p = csvField(p, end, value, sizeof(value));
+		p = csvField(p, end, error, sizeof(error));
+		while (p < end && *p != '\n')
+			p++;
+		p++;
+
+		if (atoi(error) < 0)
+			continue;
+
+		if (strcmp(key, "model") == 0) {
+			memcpy(report->model, value, FIELD_SIZE);
+			report->ok = 1;
+		} else if (strcmp(key, "firmware") == 0) {
+			memcpy(report->firmware, value, FIELD_SIZE);
+		} else if (strcmp(key, "region_no") == 0) {
+			memcpy(report->region, value, FIELD_SIZE);
+		} else if (strcmp(key, "battery_soh") == 0) {
+			report->soh = atoi(value);
+		}
+	}
+}
+
+static int loadReport(const char *path, Report *report)
+{
+	struct stat st;
+	void *data;
+	int fd = open(path, O_RDONLY);
+
+	memset(report, 0, sizeof(*report));
+	if (fd < 0)
+		return -1;
+	if (fstat(fd, &st) < 0 || st.st_size == 0) {
+		close(fd);
+		return -1;
+	}
+
+	data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return -1;
+
+	parseReport(data, (const char *)data + st.st_size, report);
+	munmap(data, st.st_size);
+	return report->ok ? 0 : -1;
+}
+
+static int next_path;
+
+// workers pull files one at a time, so a few slow ones don't stall a slice
+static void *ingestWorker(void *arg)
+{
+	int i;
+
+	while ((i = __sync_fetch_and_add(&next_path, 1)) < path_count)
+		loadReport(paths[i], &reports[i]);
+	return NULL;
+}
+
+static void ingest(int threads)
+{
+	pthread_t *workers = xmalloc(threads * sizeof(pthread_t));
+	int i;
+
+	reports = xmalloc(path_count * sizeof(Report));
+	next_path = 0;
+
+	for (i = 0; i < threads; i++) {
+		if (pthread_create(&workers[i], NULL, ingestWorker, NULL) != 0) {
+			threads = i;
+			break;
+		}
+	}
+	if (threads == 0)
+		ingestWorker(NULL);
+	for (i = 0; i < threads; i++)
+		pthread_join(workers[i], NULL);
+
+	free(workers);
+}
+
+/****************************** index ****************************************/
+
+static const char *modelOf(int i)    { return reports[i].model; }
+static const char *firmwareOf(int i) { return reports[i].firmware; }
+static const char *regionOf(int i)   { return reports[i].region; }
+
+// distinct values are few (a handful of models, dozens of firmwares), so a
+// linear probe of the key list is plenty
+static void buildIndex(Index *index, const char *(*value)(int))
+{
+	int i, k, *fill;
+
+	index->keys = xmalloc(path_count * sizeof(char *));
+	index->key_of = xmalloc(path_count * sizeof(int));
+	index->key_count = 0;
+
+	for (i = 0; i < path_count; i++) {
+		const char *v = value(i);
+
+		index->key_of[i] = -1;
+		if (!reports[i].ok)
+			continue;
+
+		for (k = index->key_count - 1; k >= 0; k--) {
+			if (strcmp(index->keys[k], v) == 0)
+				break;
+		}
+		if (k < 0) {
+			k = index->key_count++;
+			index->keys[k] = (char *)v;
+		}
+		index->key_of[i] = k;
+	}
+
+	// counting sort of the reports by key
+	index->first = calloc(index->key_count + 1, sizeof(int));
+	index->units = xmalloc(path_count * sizeof(int));
+	fill = calloc(index->key_count + 1, sizeof(int));
+	if (index->first == NULL || fill == NULL) {
+		perror("calloc");
+		exit(2);
+	}
+
+	for (i = 0; i < path_count; i++) {
+		if (index->key_of[i] >= 0)
+			index->first[index->key_of[i] + 1]++;
+	}
+	for (k = 0; k < index->key_count; k++)
+		index->first[k + 1] += index->first[k];
+	for (i = 0; i < path_count; i++) {
+		k = index->key_of[i];
+		if (k >= 0)
+			index->units[index->first[k] + fill[k]++] = i;
+	}
+	free(fill);
+}
+
+static int *by_soh;
+static int soh_count;
+
+static int compareSoh(const void *a, const void *b)
+{
+	return reports[*(const int *)a].soh - reports[*(const int *)b].soh;
+}
+
+static void buildSohIndex()
+{
+	int i;
+
+	by_soh = xmalloc(path_count * sizeof(int));
+	soh_count = 0;
+	for (i = 0; i < path_count; i++) {
+		if (reports[i].ok && reports[i].soh != NO_SOH)
+			by_soh[soh_count++] = i;
+	}
+	qsort(by_soh, soh_count, sizeof(int), compareSoh);
+}
+
+// first position in by_soh with soh >= value
+static int sohLowerBound(int value)
+{
+	int lo = 0, hi = soh_count;
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (reports[by_soh[mid]].soh < value)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/****************************** queries ****************************************/
+
+// PCH/VTE numbers people search for, in terms of what convert_model() reports
+static const struct {
+	const char *alias;
+	const char *model;
+} model_aliases[] = {
+	{ "PCH-1000", "Vita Fat" },
+	{ "PCH-2000", "Vita Slim" },
+	{ "VTE-1000", "PlayStation TV" },
+};
+
+// PCH-2001 is as much a Slim as PCH-2000, so only the series digit counts
+static const char *modelPattern(const char *pattern)
+{
+	unsigned i;
+
+	for (i = 0; i < sizeof(model_aliases) / sizeof(model_aliases[0]); i++) {
+		if (strncasecmp(pattern, model_aliases[i].alias, 5) == 0)
+			return model_aliases[i].model;
+	}
+	return pattern;
+}
+
+typedef struct {
+	const char *model, *firmware, *region;
+	int soh_below, soh_at_least;	// -1: not filtering
+} Query;
+
+// keys of the index whose value contains pattern, NULL: no filter
+static char *matchKeys(const Index *index, const char *pattern)
+{
+	char *match;
+	int k;
+
+	if (pattern == NULL)
+		return NULL;
+
+	match = calloc(index->key_count + 1, 1);
+	if (match == NULL) {
+		perror("calloc");
+		exit(2);
+	}
+	for (k = 0; k < index->key_count; k++)
+		match[k] = strstr(index->keys[k], pattern) != NULL;
+	return match;
+}
+
+static int keyMatches(const Index *index, const char *match, int i)
+{
+	return match == NULL || (index->key_of[i] >= 0 && match[index->key_of[i]]);
+}
+
+// candidates come from the SOH range when one is given, otherwise from the
+// postings of the matching models; the other filters are checked per unit
+static int runQuery(const Query *query, const Index *models, const Index *firmwares,
+	const Index *regions, int **out)
+{
+	char *model_match = matchKeys(models, query->model);
+	char *firmware_match = matchKeys(firmwares, query->firmware);
+	char *region_match = matchKeys(regions, query->region);
+	int *result = xmalloc(path_count * sizeof(int));
+	int count = 0, i, k, from, to;
+
+	if (query->soh_below >= 0 || query->soh_at_least >= 0) {
+		from = query->soh_at_least >= 0 ? sohLowerBound(query->soh_at_least) : 0;
+		to = query->soh_below >= 0 ? sohLowerBound(query->soh_below) : soh_count;
+		for (; from < to; from++) {
+			i = by_soh[from];
+			if (keyMatches(models, model_match, i) && keyMatches(firmwares, firmware_match, i) &&
+					keyMatches(regions, region_match, i))
+				result[count++] = i;
+		}
+	} else {
+		for (k = 0; k < models->key_count; k++) {
+			if (model_match && !model_match[k])
+				continue;
+			for (from = models->first[k]; from < models->first[k + 1]; from++) {
+				i = models->units[from];
+				if (keyMatches(firmwares, firmware_match, i) && keyMatches(regions, region_match, i))
+					result[count++] = i;
+			}
+		}
+	}
+
+	free(model_match);
+	free(firmware_match);
+	free(region_match);
+	*out = result;
+	return count;
+}
+
+static void printSummary(const char *title, const Index *index)
+{
+	int k;
+
+	printf("%s\n", title);
+	for (k = 0; k < index->key_count; k++)
+		printf("  %8d  %s\n", index->first[k + 1] - index->first[k], index->keys[k]);
+}
+
+/****************************** synthetic corpus ****************************************/
+
+static unsigned rng_state = 12345;
+
+static unsigned rng()
+{
+	rng_state = rng_state * 1103515245 + 12345;
+	return rng_state >> 8;
+}
+
+// same layout exportCsv() writes on the Vita
+static int writeSynthetic(const char *dir, int count)
+{
+	static const char *models[] = {
+		"Vita Fat (0x00010000)", "Vita Slim (0x00010000)", "PlayStation TV (0x00020000)",
+	};
+	static const char *firmwares[] = {
+		"3.60 HENkaku v8 CEX", "3.65 CEX", "3.67 CEX", "3.68 CEX", "3.60 Test/Dev Kit", "3.70 CEX (IDU)",
+	};
+	static const char *regions[] = {
+		"Japan", "North America", "Australia", "United Kingdom", "Europe", "Russia", "Asia",
+	};
+	char path[4096];
+	FILE *fp;
+	int i, model;
+
+	mkdir(dir, 0777);
+	for (i = 0; i < count; i++) {
+		snprintf(path, sizeof(path), "%s/unit%06d.csv", dir, i);
+		fp = fopen(path, "w");
+		if (fp == NULL) {
+			perror(path);
+			return -1;
+		}
+
+		model = rng() % 3;
+		fprintf(fp, "key,category,label,value,error\n");
+		fprintf(fp, "model,device,\"Vita model\",\"%s\",0\n", models[model]);
+		fprintf(fp, "firmware,device,\"Kernel version\",\"%s\",0\n", firmwares[rng() % 6]);
+		fprintf(fp, "mac,device,\"MAC address\",\"%02X:%02X:%02X:%02X:%02X:%02X\",0\n",
+			rng() & 0xFF, rng() & 0xFF, rng() & 0xFF, rng() & 0xFF, rng() & 0xFF, rng() & 0xFF);
+		fprintf(fp, "storage,device,\"MemoryCard\",\"%u.00 GB / 64.00 GB\",0\n", rng() % 64);
+		if (model != 2) {
+			fprintf(fp, "battery_percent,battery,\"Battery percentage\",\"%u%%\",0\n", rng() % 101);
+			fprintf(fp, "battery_soh,battery,\"State of Health\",\"%u%%\",0\n", 50 + rng() % 51);
+		}
+		fprintf(fp, "language,registry,\"language\",\"English US\",0\n");
+		fprintf(fp, "region_no,registry,\"region_no\",\"%s\",0\n", regions[rng() % 7]);
+		fprintf(fp, "psn_nickname,psn,\"PSN Nickname\",\"user%d\",0\n", i);
+		fclose(fp);
+	}
+	return 0;
+}
+
+/****************************** main ****************************************/
+
+static void usage()
+{
+	fprintf(stderr,
+		"usage: psvfleet [options] <report.csv|dir>...\n"
+		"  -m model     model contains text, PCH-1000/PCH-2000/VTE-1000 also work\n"
+		"  -f firmware  kernel version and mode contain text, e.g. \"3.60\" or \"Dev Kit\"\n"
+		"  -r region    region_no contains text\n"
+		"  -s percent   State of Health below percent\n"
+		"  -S percent   State of Health at least percent\n"
+		"  -l           list the matching report files\n"
+		"  -j threads   parse with this many threads (default: one per core)\n"
+		"  -g count     write a synthetic corpus of count reports to the first dir and exit\n");
+}
+
+int main(int argc, char *argv[])
+{
+	Query query = { NULL, NULL, NULL, -1, -1 };
+	Index models, firmwares, regions;
+	int threads = sysconf(_SC_NPROCESSORS_ONLN);
+	int list = 0, generate = 0, ok = 0;
+	int *result, count, i;
+	double start, ingest_time, index_time, query_time;
+
+	for (i = 1; i < argc; i++) {
+		if (argv[i][0] != '-')
+			addArgument(argv[i]);
+		else if (strcmp(argv[i], "-l") == 0)
+			list = 1;
+		else if (i + 1 >= argc) {
+			usage();
+			return 2;
+		} else if (strcmp(argv[i], "-m") == 0)
+			query.model = modelPattern(argv[++i]);
+		else if (strcmp(argv[i], "-f") == 0)
+			query.firmware = argv[++i];
+		else if (strcmp(argv[i], "-r") == 0)
+			query.region = argv[++i];
+		else if (strcmp(argv[i], "-s") == 0)
+			query.soh_below = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-S") == 0)
+			query.soh_at_least = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-j") == 0)
+			threads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-g") == 0) {
+			generate = atoi(argv[++i]);
+			if (i + 1 < argc)
+				return writeSynthetic(argv[++i], generate) < 0;
+			usage();
+			return 2;
+		} else {
+			usage();
+			return 2;
+		}
+	}
+
+	if (path_count == 0) {
+		usage();
+		return 2;
+	}
+	if (threads < 1)
+		threads = 1;
+
+	start = now();
+	ingest(threads);
+	ingest_time = now() - start;
+
+	start = now();
+	buildIndex(&models, modelOf);
+	buildIndex(&firmwares, firmwareOf);
+	buildIndex(&regions, regionOf);
+	buildSohIndex();
+	index_time = now() - start;
+
+	for (i = 0; i < path_count; i++)
+		ok += reports[i].ok;
+
+	start = now();
+	count = runQuery(&query, &models, &firmwares, &regions, &result);
+	query_time = now() - start;
+
+	printf("%d reports (%d unreadable), %d threads: ingest %.1f ms (%.0f reports/s), index %.1f ms\n",
+		path_count, path_count - ok, threads, ingest_time * 1e3,
+		path_count / (ingest_time > 0 ? ingest_time : 1e-9), index_time * 1e3);
+
+	if (query.model || query.firmware || query.region || query.soh_below >= 0 || query.soh_at_least >= 0) {
+		printf("%d matching units, query %.3f ms\n", count, query_time * 1e3);
+		if (list) {
+			for (i = 0; i < count; i++) {
+				const Report *r = &reports[result[i]];
+				printf("  %s  %s | %s | %s | SOH %d%%\n", paths[result[i]], r->model, r->firmware,
+					r->region, r->soh);
+			}
+		}
+	} else {
+		printSummary("models", &models);
+		printSummary("firmware", &firmwares);
+		printSummary("regions", &regions);
+	}
+
+	free(result);
+	return 0;
+}
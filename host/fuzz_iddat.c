@@ -0,0 +1,152 @@
+/*
+ * Fuzz target for the id.dat parser (iddat.c).
+ *
+ * Built with clang -fsanitize=fuzzer -DLIBFUZZER this is a plain libFuzzer
+ * target. Otherwise main() feeds it the files named on the command line, or
+ * a stream of generated inputs, under whatever sanitizers it was built with.
+ * Any broken invariant aborts.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "../iddat.h"
+
+#define CHECK(cond) do { if (!(cond)) { fprintf(stderr, "check failed: %s\n", #cond); abort(); } } while (0)
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	static const int copy_sizes[] = { 1, 2, 4, 50, 64 };
+	char out[64];
+	char *buf;
+	IdDat dat;
+	int key, i, n, lines = 1, len;
+
+	if (size > IDDAT_MAX_SIZE)
+		size = IDDAT_MAX_SIZE;
+
+	// exact size, so ASan flags any read past the end
+	buf = malloc(size ? size : 1);
+	memcpy(buf, data, size);
+	for (i = 0; i < (int)size; i++)
+		lines += buf[i] == '\n';
+
+	CHECK(idDatParse(&dat, buf, size) == (dat.unknown ? 1 : 0));
+	CHECK(dat.unknown >= 0 && dat.unknown <= lines);
+
+	for (key = 0; key < IDDAT_KEY_COUNT; key++) {
+		const IdDatSlice *value = &dat.values[key];
+
+		CHECK(value->len >= 0);
+		if (value->len == 0)
+			continue;
+
+		// a slice of the input, right after KEY=, within one line
+		CHECK(value->data > buf && value->data + value->len <= buf + size);
+		CHECK(value->data[-1] == '=');
+		CHECK(memchr(value->data, '\n', value->len) == NULL);
+
+		for (i = 0; i < (int)(sizeof(copy_sizes) / sizeof(copy_sizes[0])); i++) {
+			n = copy_sizes[i];
+			memset(out, 'x', sizeof(out));
+			idDatCopy(&dat, key, out, n);
+			len = value->len < n - 1 ? value->len : n - 1;
+			CHECK(out[len] == '\0');
+			CHECK(memcmp(out, value->data, len) == 0);
+			if (n < (int)sizeof(out))
+				CHECK(out[n] == 'x');	// never writes past size
+		}
+	}
+
+	free(buf);
+	return 0;
+}
+
+#ifndef LIBFUZZER
+
+static unsigned rng_state;
+
+static unsigned rng()
+{
+	rng_state = rng_state * 1103515245 + 12345;
+	return rng_state >> 8;
+}
+
+// mostly id.dat shaped: known and unknown keys, stray '=' and line endings,
+// values from empty to far longer than the old 50-byte fields
+static size_t generate(uint8_t *out, size_t cap)
+{
+	static const char *pieces[] = {
+		"MID=", "DIG=", "DID=", "AID=", "OID=", "SVR=", "XYZ=", "MI=", "MIDD=", "=",
+		"\n", "\r\n", "\r", " ", "\t", "0123456789abcdef", "user",
+	};
+	size_t len = 0, n;
+	int parts = rng() % 40, i, j;
+
+	for (i = 0; i < parts && len < cap; i++) {
+		switch (rng() % 4) {
+		case 0:	// raw bytes, NULs included
+			n = rng() % 16;
+			for (j = 0; j < (int)n && len < cap; j++)
+				out[len++] = rng();
+			break;
+		case 1:	// a long value
+			n = rng() % 300;
+			for (j = 0; j < (int)n && len < cap; j++)
+				out[len++] = 'A' + rng() % 26;
+			break;
+		default:
+			j = rng() % (sizeof(pieces) / sizeof(pieces[0]));
+			n = strlen(pieces[j]);
+			if (n > cap - len)
+				n = cap - len;
+			memcpy(out + len, pieces[j], n);
+			len += n;
+			break;
+		}
+	}
+	return len;
+}
+
+int main(int argc, char *argv[])
+{
+	static uint8_t input[IDDAT_MAX_SIZE + 256];
+	long iterations = 100000, it;
+	size_t size;
+	FILE *fp;
+	int i, files = 0;
+
+	rng_state = 1;
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			iterations = atol(argv[++i]);
+		} else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+			rng_state = atoi(argv[++i]);
+		} else {
+			fp = fopen(argv[i], "rb");
+			if (fp == NULL) {
+				perror(argv[i]);
+				return 2;
+			}
+			size = fread(input, 1, sizeof(input), fp);
+			fclose(fp);
+			LLVMFuzzerTestOneInput(input, size);
+			files++;
+		}
+	}
+	if (files) {
+		printf("%d files ok\n", files);
+		return 0;
+	}
+
+	for (it = 0; it < iterations; it++) {
+		size = generate(input, sizeof(input));
+		LLVMFuzzerTestOneInput(input, size);
+	}
+	printf("%ld generated inputs ok\n", iterations);
+	return 0;
+}
+
+#endif
@@ -0,0 +1,206 @@
+/*
+ * Host side font converter.
+ *
+ * Turns an 8x8 BDF bitmap font (misaki_gothic.bdf for kana and kanji, or
+ * any other with 8 pixel glyphs) into the fallback font fontfile.c reads.
+ * ASCII is skipped, the built-in font covers it. -r limits the output to
+ * codepoint ranges, e.g. -r 0400-04FF,3000-30FF,4E00-9FFF.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../fontfile.h"
+
+#define MAX_RANGES 32
+
+typedef struct {
+	unsigned cp;
+	unsigned char bits[PSV_FONT_GLYPH_SIZE];
+} Glyph;
+
+static unsigned ranges[MAX_RANGES][2];
+static int range_count;
+
+static Glyph glyphs[0x10000];
+static int glyph_count;
+
+/****************************** options ****************************************/
+
+static int parseRanges(const char *spec)
+{
+	char *end;
+
+	while (*spec && range_count < MAX_RANGES) {
+		ranges[range_count][0] = strtoul(spec, &end, 16);
+		if (*end == '-')
+			ranges[range_count][1] = strtoul(end + 1, &end, 16);
+		else
+			ranges[range_count][1] = ranges[range_count][0];
+		if (end == spec || (*end && *end != ','))
+			return -1;
+		range_count++;
+		spec = *end ? end + 1 : end;
+	}
+	return *spec ? -1 : 0;
+}
+
+static int wanted(unsigned cp)
+{
+	int i;
+
+	if (cp < 0x80 || cp > 0xFFFF)
+		return 0;
+	if (range_count == 0)
+		return 1;
+	for (i = 0; i < range_count; i++)
+		if (cp >= ranges[i][0] && cp <= ranges[i][1])
+			return 1;
+	return 0;
+}
+
+/****************************** BDF ****************************************/
+
+// glyphs are placed on the font's baseline, pixels outside 8x8 are an error
+static int readBdf(FILE *fp, int *skipped)
+{
+	char line[256];
+	int box_h = 8, box_y = 0, box_x = 0;
+	int w = 0, h = 0, xoff = 0, yoff = 0;
+	int encoding = -1, row = -1, top = 0, fits = 1;
+	Glyph *glyph = NULL;
+
+	while (fgets(line, sizeof(line), fp)) {
+		if (sscanf(line, "FONTBOUNDINGBOX %*d %d %d %d", &box_h, &box_x, &box_y) == 3) {
+			if (box_h > 8)
+				fprintf(stderr, "warning: font is %d pixels high, taller glyphs are skipped\n", box_h);
+		} else if (sscanf(line, "ENCODING %d", &encoding) == 1) {
+			glyph = NULL;
+			row = -1;
+		} else if (sscanf(line, "BBX %d %d %d %d", &w, &h, &xoff, &yoff) == 4) {
+			// rows from the top of the 8x8 cell, baseline at box_h + box_y
+			top = box_h + box_y - (h + yoff);
+			xoff -= box_x;
+			fits = w + xoff <= 8 && xoff >= 0 && top >= 0 && top + h <= 8;
+		} else if (strncmp(line, "BITMAP", 6) == 0) {
+			if (encoding >= 0 && wanted(encoding)) {
+				if (fits) {
+					glyph = &glyphs[glyph_count++];
+					memset(glyph, 0, sizeof(*glyph));
+					glyph->cp = encoding;
+					row = 0;
+				} else {
+					(*skipped)++;
+				}
+			}
+		} else if (strncmp(line, "ENDCHAR", 7) == 0) {
+			glyph = NULL;
+			encoding = -1;
+		} else if (glyph && row < h) {
+			// one hex row, glyphs this narrow fit its first byte
+			unsigned bits;
+			if (sscanf(line, "%2x", &bits) == 1)
+				glyph->bits[top + row++] = bits >> xoff;
+		}
+	}
+	return glyph_count;
+}
+
+static int compareGlyphs(const void *a, const void *b)
+{
+	return (int)((const Glyph *)a)->cp - (int)((const Glyph *)b)->cp;
+}
+
+/****************************** output ****************************************/
+
+static void put16(unsigned char *p, unsigned v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+}
+
+static int writeFont(const char *path)
+{
+	unsigned char header[PSV_FONT_HEADER_SIZE], cp[2];
+	FILE *fp;
+	int i, count = 0;
+
+	// duplicates keep the first glyph
+	qsort(glyphs, glyph_count, sizeof(Glyph), compareGlyphs);
+	for (i = 0; i < glyph_count; i++)
+		if (count == 0 || glyphs[count - 1].cp != glyphs[i].cp)
+			glyphs[count++] = glyphs[i];
+
+	if ((fp = fopen(path, "wb")) == NULL) {
+		perror(path);
+		return -1;
+	}
+	memcpy(header, PSV_FONT_MAGIC, 4);
+	put16(header + 4, PSV_FONT_VERSION);
+	header[6] = 8;
+	header[7] = 8;
+	put16(header + 8, count);
+	put16(header + 10, count >> 16);
+	fwrite(header, 1, sizeof(header), fp);
+	for (i = 0; i < count; i++) {
+		put16(cp, glyphs[i].cp);
+		fwrite(cp, 1, 2, fp);
+	}
+	for (i = 0; i < count; i++)
+		fwrite(glyphs[i].bits, 1, PSV_FONT_GLYPH_SIZE, fp);
+
+	if (fclose(fp) != 0) {
+		perror(path);
+		return -1;
+	}
+	printf("%s: %d glyphs, %d bytes\n", path, count,
+		PSV_FONT_HEADER_SIZE + count * (2 + PSV_FONT_GLYPH_SIZE));
+	return 0;
+}
+
+static void usage()
+{
+	fprintf(stderr,
+		"usage: mkfont [-r ranges] font.bdf out.fnt\n"
+		"  -r ranges  hex codepoint ranges to keep, e.g. 0400-04FF,3000-30FF\n");
+}
+
+int main(int argc, char *argv[])
+{
+	const char *in = NULL, *out = NULL;
+	int skipped = 0;
+	FILE *fp;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+			if (parseRanges(argv[++i]) < 0) {
+				usage();
+				return 2;
+			}
+		} else if (!in) {
+			in = argv[i];
+		} else if (!out) {
+			out = argv[i];
+		} else {
+			usage();
+			return 2;
+		}
+	}
+	if (!out) {
+		usage();
+		return 2;
+	}
+
+	if ((fp = fopen(in, "r")) == NULL) {
+		perror(in);
+		return 1;
+	}
+	readBdf(fp, &skipped);
+	fclose(fp);
+
+	if (skipped)
+		fprintf(stderr, "warning: %d glyphs larger than 8x8 skipped\n", skipped);
+	return writeFont(out) < 0;
+}
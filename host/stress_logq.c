@@ -0,0 +1,215 @@
+/*
+ * Host side log queue stress test.
+ *
+ * Several producer threads push numbered records into logq.c while one
+ * consumer pops them, checking that nothing arrives torn, duplicated or out
+ * of order per producer, and that every record was either received or
+ * counted as dropped. Producer latency per push is reported next to the
+ * old path: psvDebugScreenPrintf behind one mutex, as g_log_mutex did.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include "../graphics.h"
+#include "../logq.h"
+
+#define MAX_PRODUCERS 16
+
+static int producers = 4;
+static int records = 20000;	// per producer
+static int render = 0;			// consumer prints what it pops
+
+static long long *latency[MAX_PRODUCERS];
+static int pushed[MAX_PRODUCERS];
+static int producers_done = 0;
+static pthread_mutex_t screen_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static long long nowNs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int compareLL(const void *a, const void *b)
+{
+	long long x = *(const long long *)a, y = *(const long long *)b;
+	return x < y ? -1 : x > y;
+}
+
+// a line a probe thread might log, with a check value over the numbers
+static unsigned check(int id, int seq)
+{
+	return (id * 2654435761u) ^ (seq * 40503u);
+}
+
+/****************************** queue ****************************************/
+
+static void *queueProducer(void *arg)
+{
+	int id = (int)(long)arg;
+	long long start;
+	int seq;
+
+	for (seq = 0; seq < records; seq++) {
+		start = nowNs();
+		if (logqPush(WHITE, "\n! p%d %d %08x registry/language failed", id, seq, check(id, seq)) == 0)
+			pushed[id]++;
+		latency[id][seq] = nowNs() - start;
+		// probes log between queries, not back to back; this also lets
+		// the consumer run when there is a single core
+		sched_yield();
+	}
+	__atomic_fetch_add(&producers_done, 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+static long long received;
+static int errors;
+
+static void *queueConsumer(void *arg)
+{
+	int next[MAX_PRODUCERS] = { 0 };
+	LogRecord record;
+	unsigned sum;
+	int id, seq;
+
+	for (;;) {
+		if (!logqPop(&record)) {
+			if (__atomic_load_n(&producers_done, __ATOMIC_ACQUIRE) == producers && !logqReady())
+				break;
+			sched_yield();
+			continue;
+		}
+		received++;
+		if (sscanf(record.text, "\n! p%d %d %x", &id, &seq, &sum) != 3 ||
+				id < 0 || id >= producers || sum != check(id, seq) || seq < next[id]) {
+			if (errors++ < 10)
+				fprintf(stderr, "bad record: %s\n", record.text + 1);
+			continue;
+		}
+		next[id] = seq + 1;
+		if (render)
+			psvDebugScreenPrintf("%s", record.text);
+	}
+	return NULL;
+}
+
+/****************************** old path ****************************************/
+
+static void *lockedProducer(void *arg)
+{
+	int id = (int)(long)arg;
+	long long start;
+	int seq;
+
+	for (seq = 0; seq < records; seq++) {
+		start = nowNs();
+		pthread_mutex_lock(&screen_mutex);
+		psvDebugScreenPrintf("\n! p%d %d %08x registry/language failed", id, seq, check(id, seq));
+		pthread_mutex_unlock(&screen_mutex);
+		latency[id][seq] = nowNs() - start;
+		sched_yield();
+	}
+	return NULL;
+}
+
+/****************************** report ****************************************/
+
+static void report(const char *name, double seconds)
+{
+	long long *all = malloc(sizeof(long long) * producers * records);
+	long long n = (long long)producers * records;
+	int i;
+
+	for (i = 0; i < producers; i++)
+		memcpy(all + (long long)i * records, latency[i], sizeof(long long) * records);
+	qsort(all, n, sizeof(long long), compareLL);
+
+	printf("%-8s %10.0f %8lld %8lld %8lld %10lld\n", name, n / seconds,
+		all[n / 2], all[n * 99 / 100], all[n * 999 / 1000], all[n - 1]);
+	free(all);
+}
+
+static double run(void *(*producer)(void *), void *(*consumer)(void *))
+{
+	pthread_t threads[MAX_PRODUCERS], reader;
+	long long start = nowNs();
+	long i;
+
+	if (consumer)
+		pthread_create(&reader, NULL, consumer, NULL);
+	for (i = 0; i < producers; i++)
+		pthread_create(&threads[i], NULL, producer, (void *)i);
+	for (i = 0; i < producers; i++)
+		pthread_join(threads[i], NULL);
+	if (consumer)
+		pthread_join(reader, NULL);
+	return (nowNs() - start) / 1e9;
+}
+
+static void usage()
+{
+	fprintf(stderr,
+		"usage: logqstress [-p producers] [-n records] [-r]\n"
+		"  -p n  producer threads (default 4, at most %d)\n"
+		"  -n n  records per producer (default 20000)\n"
+		"  -r    the consumer also prints every record to the screen\n",
+		MAX_PRODUCERS);
+}
+
+int main(int argc, char *argv[])
+{
+	long long total, accounted;
+	double seconds;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+			producers = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+			records = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-r") == 0)
+			render = 1;
+		else {
+			usage();
+			return 2;
+		}
+	}
+	if (producers < 1 || producers > MAX_PRODUCERS || records < 1) {
+		usage();
+		return 2;
+	}
+
+	for (i = 0; i < producers; i++)
+		latency[i] = malloc(sizeof(long long) * records);
+	psvDebugScreenInit();
+
+	printf("%d producers x %d records%s\n\n", producers, records,
+		render ? ", consumer draws" : "");
+	printf("%-8s %10s %8s %8s %8s %10s\n", "path", "pushes/s", "p50 ns", "p99 ns", "p99.9 ns", "max ns");
+
+	seconds = run(queueProducer, queueConsumer);
+	report("queue", seconds);
+
+	total = (long long)producers * records;
+	accounted = received + logqDropped();
+
+	seconds = run(lockedProducer, NULL);
+	report("locked", seconds);
+
+	printf("\nqueue: %lld received, %u dropped (ring full), %d bad\n",
+		received, logqDropped(), errors);
+
+	psvDebugScreenTerm();
+	if (errors || accounted != total) {
+		printf("FAIL: %lld of %lld records accounted for\n", accounted, total);
+		return 1;
+	}
+	return 0;
+}
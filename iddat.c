@@ -0,0 +1,87 @@
+#include <string.h>
+
+#include "iddat.h"
+
+#define KEY3(a, b, c) ((unsigned)(a) << 16 | (unsigned)(b) << 8 | (unsigned)(c))
+
+static const struct {
+	unsigned name;
+	IdDatKey key;
+} keys[IDDAT_KEY_COUNT] = {
+	{ KEY3('M', 'I', 'D'), IDDAT_MID },
+	{ KEY3('D', 'I', 'G'), IDDAT_DIG },
+	{ KEY3('D', 'I', 'D'), IDDAT_DID },
+	{ KEY3('A', 'I', 'D'), IDDAT_AID },
+	{ KEY3('O', 'I', 'D'), IDDAT_OID },
+	{ KEY3('S', 'V', 'R'), IDDAT_SVR },
+};
+
+static int lookupKey(const char *name, int len) {
+	unsigned packed;
+	int i;
+
+	if (len != 3)
+		return -1;
+
+	packed = KEY3((unsigned char)name[0], (unsigned char)name[1], (unsigned char)name[2]);
+	for (i = 0; i < IDDAT_KEY_COUNT; i++) {
+		if (keys[i].name == packed)
+			return keys[i].key;
+	}
+	return -1;
+}
+
+int idDatParse(IdDat *dat, const char *data, int size) {
+	const char *p = data, *end = data + size;
+	const char *line, *eq, *value_end;
+	int key;
+
+	memset(dat, 0, sizeof(*dat));
+
+	while (p < end) {
+		//one line, with the '=' found on the way
+		line = p;
+		eq = NULL;
+		while (p < end && *p != '\n') {
+			if (*p == '=' && eq == NULL)
+				eq = p;
+			p++;
+		}
+		value_end = p;
+		if (p < end)
+			p++;
+
+		//Windows line endings and trailing blanks
+		while (value_end > line && (value_end[-1] == '\r' || value_end[-1] == ' ' || value_end[-1] == '\t'))
+			value_end--;
+		if (value_end == line)
+			continue;
+
+		//leading blanks too, fscanf skipped them before the key
+		while (*line == ' ' || *line == '\t')
+			line++;
+
+		if (eq == NULL || eq >= value_end || (key = lookupKey(line, eq - line)) < 0) {
+			dat->unknown++;
+			continue;
+		}
+
+		//a repeated key replaces the earlier one, like it always did
+		dat->values[key].data = eq + 1;
+		dat->values[key].len = value_end - (eq + 1);
+	}
+
+	return dat->unknown ? 1 : 0;
+}
+
+void idDatCopy(const IdDat *dat, IdDatKey key, char *out, int size) {
+	int len = dat->values[key].len;
+
+	if (size <= 0)
+		return;
+	if (len > size - 1)
+		len = size - 1;
+	if (len > 0)
+		memcpy(out, dat->values[key].data, len);
+	out[len] = '\0';
+}
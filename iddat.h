@@ -0,0 +1,32 @@
+#pragma once
+
+// ux0:id.dat parser. The file is KEY=VALUE lines; values are kept as slices
+// of the buffer they were parsed from, nothing is copied.
+
+#define IDDAT_MAX_SIZE 4096	// more than any real id.dat, the rest is ignored
+
+typedef enum {
+	IDDAT_MID,	//unknown
+	IDDAT_DIG,	//unknown
+	IDDAT_DID,	//PSID
+	IDDAT_AID,	//DRM Account name - or "NP/account_id" in registry
+	IDDAT_OID,	//username
+	IDDAT_SVR,	//firmware
+	IDDAT_KEY_COUNT
+} IdDatKey;
+
+typedef struct {
+	const char *data;	// not NUL-terminated
+	int len;
+} IdDatSlice;
+
+typedef struct {
+	IdDatSlice values[IDDAT_KEY_COUNT];	// len 0 when the key is missing
+	int unknown;	// lines with a key not in the table, or no '='
+} IdDat;
+
+// one pass over data; returns 1 if there were unknown lines, else 0
+int idDatParse(IdDat *dat, const char *data, int size);
+
+// copies a value with a terminating NUL, cut to fit size
+void idDatCopy(const IdDat *dat, IdDatKey key, char *out, int size);
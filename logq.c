@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "logq.h"
+
+// Bounded ring after Vyukov: each slot carries a sequence number saying
+// whose turn it is. Producers claim a position with one CAS on tail and
+// publish by bumping the slot's sequence, so a slow producer only holds
+// back the consumer, never another producer.
+//
+// seq is stored minus the slot index, so the zeroed ring is already the
+// initial state (slot i free for position i). Shared words are only
+// touched through the __atomic builtins, acquire on load and release on
+// store, which is all the ordering the ring needs.
+typedef struct {
+	unsigned seq;
+	LogRecord record;
+} LogSlot;
+
+static LogSlot slots[LOGQ_SIZE];
+static unsigned tail = 0;		// next position to claim
+static unsigned head = 0;		// consumer only
+static unsigned dropped = 0;
+
+int logqPushV(Color color, const char *format, va_list args) {
+	unsigned pos = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+	unsigned index;
+	LogSlot *slot;
+	int diff;
+
+	for (;;) {
+		index = pos & (LOGQ_SIZE - 1);
+		slot = &slots[index];
+		diff = (int)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - (pos - index));
+
+		if (diff == 0) {
+			//a failed CAS reloads pos with the current tail
+			if (__atomic_compare_exchange_n(&tail, &pos, pos + 1, 1,
+					__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		} else if (diff < 0) {
+			//the consumer hasn't freed this slot from the last lap yet
+			__atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+			return -1;
+		} else {
+			pos = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+		}
+	}
+
+	slot->record.color = color;
+	vsnprintf(slot->record.text, LOGQ_TEXT, format, args);
+
+	__atomic_store_n(&slot->seq, pos + 1 - index, __ATOMIC_RELEASE);
+	return 0;
+}
+
+int logqPush(Color color, const char *format, ...) {
+	va_list args;
+	int ret;
+
+	va_start(args, format);
+	ret = logqPushV(color, format, args);
+	va_end(args);
+	return ret;
+}
+
+int logqPop(LogRecord *record) {
+	unsigned index = head & (LOGQ_SIZE - 1);
+	LogSlot *slot = &slots[index];
+
+	if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != head + 1 - index)
+		return 0;
+
+	memcpy(record, &slot->record, sizeof(*record));
+
+	//hand the slot to whoever claims it on the next lap
+	__atomic_store_n(&slot->seq, head + LOGQ_SIZE - index, __ATOMIC_RELEASE);
+	head++;
+	return 1;
+}
+
+int logqReady() {
+	unsigned index = head & (LOGQ_SIZE - 1);
+
+	return __atomic_load_n(&slots[index].seq, __ATOMIC_ACQUIRE) == head + 1 - index;
+}
+
+unsigned logqDropped() {
+	return __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+}
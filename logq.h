@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdarg.h>
+
+#include "graphics.h"
+
+// Log records from any thread, for the thread that owns the screen to
+// draw. Pushing formats straight into a slot of a fixed ring and never
+// waits: a producer that finds the ring full drops its record and counts
+// it. One consumer pops records in the order their slots were claimed.
+
+#define LOGQ_SIZE 256		// records, a power of two
+#define LOGQ_TEXT 120		// bytes per record including the NUL
+
+typedef struct {
+	Color color;
+	char text[LOGQ_TEXT];
+} LogRecord;
+
+// 0 when queued, -1 when the ring was full and the record was dropped
+int logqPush(Color color, const char *format, ...);
+int logqPushV(Color color, const char *format, va_list args);
+
+// consumer only: copies the oldest record out, 0 if there is none ready
+int logqPop(LogRecord *record);
+
+// consumer only: whether logqPop would return a record
+int logqReady();
+
+// records dropped so far because the ring was full
+unsigned logqDropped();
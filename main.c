@@ -1,26 +1,26 @@
 #include <stdio.h>
 #include <string.h>
-#include <stdlib.h>
-#include <stdarg.h>
 
-#include <psp2/appmgr.h>
-#include <psp2/apputil.h>
 #include <psp2/ctrl.h>
-#include <psp2/io/fcntl.h>
-#include <psp2/power.h>
-#include <psp2/kernel/threadmgr.h>
 #include <psp2/kernel/processmgr.h>
-#include <psp2/system_param.h>
-#include <psp2/net/net.h>
-#include <psp2/net/netctl.h>
-#include <psp2/screenshot.h>
-#include <psp2/sysmodule.h>
+#include <psp2/kernel/threadmgr.h>
 
 #include "graphics.h"
+#include "battery.h"
+#include "export.h"
+#include "logq.h"
+#include "profile.h"
+#include "scroll.h"
+#include "snapshot.h"
+#include "sysinfo.h"
 
 #define printf psvDebugScreenPrintf
-#define NET_INIT_SIZE 1 * 1024 * 1024
-#define NET_CTL_ERROR_NOT_TERMINATED 0x80412102
+#define REFRESH_INTERVAL 1000000 //us between live value updates
+#define BATTERY_SAMPLE_INTERVAL 1000000 //us between battery samples
+#define FONT_PATH "app0:resource/unicode8.fnt" //glyphs past ASCII, optional
+#define REPORT_ROWS 240 //text rows a page can take up, the screen shows 60
+#define TEXT_LINE 9 //px, one row of console text
+#define BACKGROUND_TIMEOUT 5000000 //us to wait for the background read when it's needed
 
 
 /* TO DO
@@ -32,6 +32,26 @@
 
 
 /* Changelog
+v0.30
+- report is drawn double-buffered and shown in one frame
+- text scrolls instead of wiping the screen when it gets too long
+- battery, clock and free space values update live, no more relaunching
+- all values are collected up front, then drawn
+- values are collected on several threads at once for a faster start
+- network stack is only loaded while reading the MAC, saves 1 MB of memory
+- startup profile page (Triangle), also saved to ux0:data/PSVident/profile.txt
+- export the report as JSON and CSV to ux0:data/PSVident/ (Square)
+- battery history graphs for percentage, temperature and voltage, plus drain rate
+- large print page (X)
+- UTF-8 text, Cyrillic and CJK from resource/unicode8.fnt when it's packed
+- probe threads log failures through a lock-free queue, shown under the report
+- main loop sleeps until the next controller sample instead of spinning,
+  its CPU time per idle second is shown under the report
+- report scrolls with the D-Pad and the left stick instead of running off
+  the bottom of the screen
+- report split into tabs (L/R), each probed the first time it is shown; the
+  MAC is read in the background so the identity tab shows right away
+
 v0.29
 - fixed 'temperature' typo
 - added Fahrenheit version for US language setting
@@ -61,137 +81,6 @@ v0.2
 */
 
 
-//! for MAC
-static char mac_string[32];
-static void *net_memory = NULL;
-
-//! id.dat
-char buff[255];
-char mid[50];  //unknown
-char dig[50];  //unknown
-char did[50];  //PSID
-char aid[50];  //DRM Account name - or "NP/account_id" in registry
-char oid[255]; //username
-char svr[50];  //firmware
-
-//! Registry
-int sceRegMgrGetKeyInt(const char* reg, const char* key, int* val);
-int sceRegMgrGetKeyStr(const char* reg, const char* key, char* str, const int buf_size);
-
-//! Battery
-int scePowerIsBatteryExist();
-int scePowerGetBatteryTemp();
-int scePowerGetBatteryVolt();
-int scePowerGetBatterySOH();
-
-//! Vita model
-int sceKernelGetModelForCDialog();
-
-//! System Version
-typedef struct {
-	SceUInt size;
-	SceChar8 version_string[28];
-	SceUInt version_value;
-	SceUInt unk;
-} SceSystemSwVersionParam;
-int sceKernelGetSystemSwVersion(SceSystemSwVersionParam *param);
-
-//! Memory Card checks
-int vshMemoryCardGetCardInsertState();
-int vshRemovableMemoryGetCardInsertState();
-
-//! Console CID/IDPS
-int _vshSblAimgrGetConsoleId(char CID[16]);
-
-char *getCID() {
-	
-	int i;
-	char CID[16];
-	static char cid_string[16];
-	
-	_vshSblAimgrGetConsoleId(CID);
-
-	for (i = 0; i < 16; i++) {
-		sprintf(cid_string + strlen(cid_string), "%02X", CID[i]);
-	}
-	
-	return cid_string;
-}
-
-//! clock freq
-int getClockFrequency(int no){
-	if (no == 0) return scePowerGetArmClockFrequency();
-	else if (no == 1)	return scePowerGetBusClockFrequency();
-	else if (no == 2)	return scePowerGetGpuClockFrequency();
-	else return 0;
-}
-	
-//! CEX, DEX, Test, IDU
-int vshSblAimgrIsCEX();				//retail
-int vshSblAimgrIsDEX();
-int vshSblAimgrIsDolce();			//PSTV
-int vshSblAimgrIsGenuineDolce();	//PSTV
-int vshSblAimgrIsGenuineVITA();		//Vita Fat&Slim
-int vshSblAimgrIsTest();	
-int vshSblAimgrIsTool();
-int vshSblAimgrIsVITA();			//Vita Fat&Slim
-int vshSysconIsIduMode();			//is IDU device (not is in DEMO MODE currently!)
-int vshSysconIsShowMode();			//is in Show Mode
-	
-const char* getMode() {
-	int cex = vshSblAimgrIsCEX();	
-	int dex = vshSblAimgrIsDEX();
-	//int test = vshSblAimgrIsTest(); /*testkits will show as DEX :/ */
-	int tool = vshSblAimgrIsTool();
-	
-	int idu = vshSysconIsIduMode();
-	int show = vshSysconIsShowMode();
-	
-	//version spoofing side effect fix here
-	if ( cex == dex ) {
-		int ret = 0;
-		int val = -1;
-
-		ret = sceRegMgrGetKeyInt("/CONFIG/SYSTEM", "debug_mode", &val); //test&dex-registry only
-		//ret = sceRegMgrGetKeyInt("/DEVENV/TOOL/", "machine_type", &val); //tool-registry only
-	
-		if (ret < 0) {
-			if ( idu ) {
-				return "CEX (IDU)";
-			} else {
-				return "CEX";
-			}
-		}	
-		return "Test/Dev Kit";
-	}
-
-	
-	//Normal detection
-	if ( cex ) {
-		if ( idu ) {
-			return "CEX (IDU)";
-		} else {
-			return "CEX";
-		}
-	/*} else if ( test ) {
-		if ( show ) {
-			return "Testing Kit (Show Mode)";
-		} else {
-			return "Testing Kit";
-		}*/
-	} else if ( dex ) {
-		if ( show ) {
-			return "Test/Dev Kit (Show Mode)";
-		} else {
-			return "Test/Dev Kit";
-		}
-	} else if ( tool ) {
-		return "Tool";
-	} else {
-		return "error";
-	}
-}
-
 //! Hardware Info
 int _vshSysconGetHardwareInfo(char HARD[4]);
 int _vshSysconGetHardwareInfo2(char HARD[4]);
@@ -221,394 +110,316 @@ void getHardware2() {
 }
 
 
-/********************* converting functions *********************************/
+/********************* report *********************************/
 
-const char* convert_button_assign(int button_assign) {
-	switch ( button_assign ) {
-		case 0: return "O = Enter";
-		case 1: return "X = Enter";
-		default: return "Unknown layout!?";
-	}
-}
+static SystemSnapshot snapshot;
 
-const char* convert_language(int language) {
-	switch ( language ) {
-		case 0: return "Japanese";
-		case 1: return "English US";
-		case 2: return "French";
-		case 3: return "Spanish";
-		case 4: return "German";
-		case 5: return "Italian";
-		case 6: return "Dutch"; 
-		case 7: return "Portuguese";
-		case 8: return "Russian"; 
-		case 9: return "Korean"; 
-		case 10: return "Traditional Chinese";
-		case 11: return "Simplified Chinese";
-		case 12: return "Finnish";
-		case 13: return "Swedish"; 
-		case 14: return "Danish";
-		case 15: return "Norwegian";
-		case 16: return "Polish";
-		case 17: return "Brazilian Portuguese";
-		case 18: return "English UK";
-		default: return "Unknown layout!?";
-	}
+//where each value was drawn, so a refresh can redraw just those cells
+typedef struct {
+	int x, y;
+	int width;
+} FieldPos;
+
+static FieldPos field_pos[FIELD_COUNT];
+static FieldPos export_status;
+static FieldPos idle_status;
+static FieldPos net_status;
+
+//tabs are probe categories, each collected the first time it is shown
+static int tab = CATEGORY_DEVICE;
+static unsigned tabs_collected = 0;
+static int serial = 0;
+
+//values still being read in the background can't be looked at yet
+const char *fieldText(FieldValue *value) {
+	return value->pending ? "reading..." : value->text;
 }
 
-const char* convert_model(int model) {
-	char fat_string[] = "D4:4B:5E";
+const char *fieldLabel(const ProbeDesc *probe) {
+	FieldValue *value = &snapshot.fields[probe->id];
 	
-	switch ( model ) {
-		case 65536: //0x10000
-			//Fat or Slim by MAC Address until theres a better solution
-			if(strstr(mac_string, fat_string)) {
-				return "Vita Fat";
-			} else {
-				return "Vita Slim";
-			}
-		case 131072: return "PlayStation TV"; //0x20000
-		default: return "Unknown model!?";
-	}
+	return value->pending || !value->label ? probe->label : value->label;
 }
 
-
-
-/****************************** custom string functions ****************************************/
-char* stringReplace(char*, char*, char*);
-
-char* stringReplace(char *search, char *replace, char *string) {
-	char *tempString, *searchStart;
-	int len=0;
-
-	searchStart = strstr(string, search);
-	if(searchStart == NULL) {
-		return string;
-	}
-
-	tempString = (char*) malloc(strlen(string) * sizeof(char));
-	if(tempString == NULL) {
-		return NULL;
+void printValue(FieldValue *value, int width) {
+	if (value->pending) {
+		Color old = psvDebugScreenSetFgColor(GREY);
+		printf("%-*s", width, fieldText(value));
+		psvDebugScreenSetFgColor(old);
+	} else if (value->error < 0) {
+		Color old = psvDebugScreenSetFgColor(RED);
+		printf("%-*s", width, value->text);
+		psvDebugScreenSetFgColor(old);
+	} else {
+		printf("%-*s", width, value->text);
 	}
+}
 
-	strcpy(tempString, string);
-
-	len = searchStart - string;
-	string[len] = '\0';
-
-	strcat(string, replace);
-
-	len += strlen(search);
-	strcat(string, (char*)tempString+len);
-
-	free(tempString);
+void printField(const ProbeDesc *probe) {
+	FieldValue *value = &snapshot.fields[probe->id];
+	FieldPos *pos = &field_pos[probe->id];
+	int i;
+	
+	printf_color("* ", probe->color);
+	printf("%-22s", fieldLabel(probe));
+	
+	//filled in when the frame is laid out, asking now would flush it
+	psvDebugScreenMarkXY(&pos->x, &pos->y);
+	pos->width = strlen(fieldText(value));
+	printValue(value, 0);
+	printf("\n");
 	
-	return string;
+	for (i = 0; i < probe->spacing; i++)
+		printf("\n");
 }
 
-void convert_dat(char* buff){
+/********************* battery sparklines *********************************/
+
+#define SPARK_SAMPLES 64
+#define SPARK_X 400			//px, right of the longest battery value
+#define SPARK_HEIGHT 8
+
+static const struct {
+	FieldId field;
+	Color color;
+} sparklines[] = {
+	{ FIELD_BATTERY_PERCENT, GREEN },
+	{ FIELD_BATTERY_TEMP,    RED },
+	{ FIELD_BATTERY_VOLTAGE, YELLOW },
+};
+
+int sparkValue(const BatterySample *sample, FieldId field) {
+	switch (field) {
+		case FIELD_BATTERY_PERCENT: return sample->percent;
+		case FIELD_BATTERY_TEMP: return sample->temp;
+		default: return sample->voltage;
+	}
+}
 
-	char mid_string[] = "MID=";
-	char dig_string[] = "DIG=";
-	char did_string[] = "DID=";
-	char aid_string[] = "AID=";
-	char oid_string[] = "OID=";
-	char svr_string[] = "SVR=";
+//fills don't survive the next frame drawn into the same buffer, so every
+//report frame draws these again
+void drawSparklines() {
+	BatterySample samples[SPARK_SAMPLES];
+	int count, i, j, v, lo, hi, h, x, y;
 	
-	char delimiter[] = "=";
-	char *ptr;
+	if (snapshot.is_dolce || tab != CATEGORY_BATTERY)
+		return;
 	
-	//printf("buffer: %s\n", buff);
+	count = batterySamples(samples, SPARK_SAMPLES);
 	
-	if(strstr(buff, mid_string)) {	
-		//printf("needle found!");
-		ptr = strtok(buff, delimiter);
-		//printf("prefix %s\n", ptr);
-		ptr = strtok(NULL, delimiter);	//next part..
-		//printf("mid found %s\n", ptr);
-		strncpy(mid, ptr, 50);
-		//printf("Mid is %s\n", ptr);
-		
-	} else if(strstr(buff, dig_string)) {
-		ptr = strtok(buff, delimiter);
-		ptr = strtok(NULL, delimiter);	
-		strncpy(dig, ptr, 50);		
-		
-	} else if(strstr(buff, did_string)) {
-		ptr = strtok(buff, delimiter);
-		ptr = strtok(NULL, delimiter);	
-		strncpy(did, ptr, 50);		
-		
-	} else if(strstr(buff, aid_string)) {
-		ptr = strtok(buff, delimiter);
-		ptr = strtok(NULL, delimiter);	
-		strncpy(aid, ptr, 50);		
-		
-	} else if(strstr(buff, oid_string)) {
-		ptr = strtok(buff, delimiter);
-		ptr = strtok(NULL, delimiter);	
-		strncpy(oid, ptr, 50);		
+	//rows come from marks left while printing this frame
+	psvDebugScreenFlush();
+	
+	for (i = 0; i < sizeof(sparklines) / sizeof(sparklines[0]); i++) {
+		//marks are page positions, fills go on the screen
+		y = field_pos[sparklines[i].field].y - psvDebugScreenGetView();
+		if (y + SPARK_HEIGHT <= 0 || y >= psvDebugScreenGetHeight())
+			continue;
+		psvDebugScreenFillRect(SPARK_X, y, SPARK_SAMPLES * 2, SPARK_HEIGHT, 0xFF202020);
 		
-	} else if(strstr(buff, svr_string)) {
-		ptr = strtok(buff, delimiter);
-		ptr = strtok(NULL, delimiter);	
-		strncpy(svr, ptr, 50);		
+		lo = hi = count ? sparkValue(&samples[0], sparklines[i].field) : 0;
+		for (j = 1; j < count; j++) {
+			v = sparkValue(&samples[j], sparklines[i].field);
+			if (v < lo) lo = v;
+			if (v > hi) hi = v;
+		}
 		
-	}else {
-		printf_color("ux0:id.dat wrongly formatted?\n", RED); 
+		//newest sample on the right
+		x = SPARK_X + (SPARK_SAMPLES - count) * 2;
+		for (j = 0; j < count; j++, x += 2) {
+			v = sparkValue(&samples[j], sparklines[i].field);
+			h = hi > lo ? 1 + (v - lo) * (SPARK_HEIGHT - 1) / (hi - lo) : SPARK_HEIGHT / 2;
+			psvDebugScreenFillRect(x, y + SPARK_HEIGHT - h, 2, h, sparklines[i].color);
+		}
 	}
 }
 
-//thx TheFloW!
-void getSizeString(char *string, uint64_t size) {
-	double double_size = (double)size;
+/********************* tabs *********************************/
 
-	int i = 0;
-	static char *units[] = { "B", "KB", "MB", "GB", "TB", "PB", "EB", "ZB", "YB" };
-	while (double_size >= 1024.0f) {
-		double_size /= 1024.0f;
-		i++;
+//no tab for a category without a field to show, like the battery on a PSTV
+int tabVisible(int category) {
+	int i;
+	
+	for (i = 0; i < probe_count; i++) {
+		if (probe_table[i].category == category && probeVisible(&snapshot, &probe_table[i]))
+			return 1;
 	}
-
-	sprintf(string, "%.*f %s", (i == 0) ? 0 : 2, double_size, units[i]);
+	return 0;
 }
 
-
-/****************************** Registry functions ****************************************/
-
-///type02 - int
-int getInteger(const char* location, const char* value) {
-	int val = -1;
-	int ret = 0;
-	
-	ret = sceRegMgrGetKeyInt(location, value, &val);
+//the next visible tab in direction dir, wrapping around
+int nextTab(int dir) {
+	int next = tab;
 	
-	if (ret < 0) {
-		psvDebugScreenSetFgColor(RED);	
-		printf("Failed to GetKeyInt: 0x%x ", ret);
-		psvDebugScreenSetFgColor(WHITE);	
-	}	
-	return val;
+	do {
+		next = (next + dir + CATEGORY_COUNT) % CATEGORY_COUNT;
+	} while (next != tab && !tabVisible(next));
+	return next;
 }
 
-///type03 - string
-char* getString( const char* reg, const char* key ) {
-	int ret = 0;
-	static char string[128];
+//runs a tab's probes the first time it is shown, later on only the
+//volatile ones are polled again
+void collectTab(int category) {
+	unsigned bit = CATEGORY_BIT(category);
 	
-	ret = sceRegMgrGetKeyStr(reg, key, string, sizeof(string)); 
+	if (tabs_collected & bit)
+		return;
 	
-	if (ret < 0) {
-		psvDebugScreenSetFgColor(RED);	
-		printf("Failed to GetKeyStr: 0x%x ", ret);
-		psvDebugScreenSetFgColor(WHITE);	
-	}	
-	return string;
+	//the drain rate comes from the sampler, no need for it before this
+	if (category == CATEGORY_BATTERY && !snapshot.is_dolce)
+		batteryStart(BATTERY_SAMPLE_INTERVAL);
+	
+	if (serial) {
+		snapshotCollect(&snapshot, PROBE_ALL, bit);
+	} else {
+		snapshotCollectParallel(&snapshot, PROBE_ALL, bit);
+	}
+	tabs_collected |= bit;
 }
 
-
-///read the region_no int by manually reading out system.dreg :/
-const char* getRegionNo() {
+void printTabs() {
+	int i;
 	
-	FILE *fp = NULL;
-    unsigned char hex[1024] = "";
-
-    if ( ( fp = fopen ( "vd0:registry/system.dreg", "rb")) == NULL) {
-        printf ( "Could not open vd0:registry/system.dreg\n");
-        return "";
-    }
-
-	fseek(fp, 92, SEEK_SET);
-	fread ( &hex, 1, 1, fp);
-	fclose(fp);
-		
-	switch ( hex[0] ) {
-		case 0: return "0";
-		case 1: return "Japan";				//PCH-X000
-		case 2: return "North America"; 	//PCH-X001
-		case 3: return "Australia";			//PCH-x002 
-		case 4: return "United Kingdom"; 	//PCH-x003
-		case 5: return "Europe"; 			//PCH-X004
-		case 6: return "Korea";				//
-		case 7: return "Asia"; 				//
-		case 8: return "Taiwan";			//
-		case 9: return "Russia"; 			//PCH-X008
-		case 10: return "Mexico"; 			//
-		case 11: return "msg_off"; 		
-		case 12: return "12"; 
-		case 13: return "China"; 			//
-		case 14: return "14"; 
-		case 15: return "15"; 
-		default: return "Unknown layout!?";
+	for (i = 0; i < CATEGORY_COUNT; i++) {
+		if (!tabVisible(i))
+			continue;
+		if (i == tab) {
+			printf_color("[", GREEN);
+			printf_color(category_names[i], GREEN);
+			printf_color("]  ", GREEN);
+		} else {
+			printf_color(" ", GREY);
+			printf_color(category_names[i], GREY);
+			printf_color("   ", GREY);
+		}
 	}
+	printf_color("L/R to switch", GREY);
 }
 
-
-/******************** Battery functions **********************************/
-
-const char* getBatteryStatus() {
-    if (!scePowerIsBatteryCharging()) return "In use";
-    else return "Charging";
+void printReport() {
+	int i;
+	
+	for (i = 0; i < probe_count; i++) {
+		const ProbeDesc *probe = &probe_table[i];
+		
+		if (probe->category == tab && probeVisible(&snapshot, probe))
+			printField(probe);
+	}
 }
 
-int getBatteryRemCapacity(){
-	char mAh[10];
-	sprintf(mAh,"%i",scePowerGetBatteryRemainCapacity());
-	int cap = atoi(mAh);	
-	return cap;
-}
-int getBatteryCapacity(){
-	char mAh[10];
-	sprintf(mAh,"%i",scePowerGetBatteryFullCapacity());
-	int cap = atoi(mAh);	
-	return cap;
-}
+/********************* idle cost *********************************/
 
-char* getBatteryPercentage() {
-	static char percentage[5];
-	sprintf(percentage, "%d%%", scePowerGetBatteryLifePercent());
-	return percentage;
-}
+//CPU time the main thread used per second while nobody touched anything,
+//refreshes included; -1 until one whole idle second has been seen
+static int idle_cpu_us = -1;
+static SceUInt64 idle_cpu_start;
+static SceInt64 idle_wall_start;
 
-char* getBatteryVoltage() {
-	static char voltage[8];
-	sprintf(voltage,"%0.2f",(float)scePowerGetBatteryVolt() / 1000.0);
-	return voltage;
+SceUInt64 threadCpuTime() {
+	SceKernelThreadInfo info;
+	
+	memset(&info, 0, sizeof(info));
+	info.size = sizeof(info);
+	if (sceKernelGetThreadInfo(sceKernelGetThreadId(), &info) < 0)
+		return 0;
+	return info.runClocks;	//us
 }
 
-char* getBatteryTempInCelsius() {
-	static char temp[8];
-	sprintf(temp,"%0.2f",(float)scePowerGetBatteryTemp() / 100.0);
-	return temp;
-}
-char* getBatteryTempInFahrenheit() {
-	static char temp[8];
-	sprintf(temp,"%0.2f",(1.8 * (float)scePowerGetBatteryTemp() / 100.0) + 32);
-	return temp;
+//input ends an idle stretch
+void idleReset() {
+	idle_cpu_start = threadCpuTime();
+	idle_wall_start = sceKernelGetProcessTimeWide();
 }
 
-/********************* initiating NET Modules for MAC *********************************/
-
-void oslLoadNetModules(){
-    if (sceSysmoduleIsLoaded(SCE_SYSMODULE_HTTP) != SCE_SYSMODULE_LOADED)
-        sceSysmoduleLoadModule(SCE_SYSMODULE_HTTP);
- 
-    if (sceSysmoduleIsLoaded(SCE_SYSMODULE_NET) != SCE_SYSMODULE_LOADED)
-        sceSysmoduleLoadModule(SCE_SYSMODULE_NET);
-}
- 
-int initnet(){
-    oslLoadNetModules();
+void idleMeasure() {
+	SceInt64 wall = sceKernelGetProcessTimeWide() - idle_wall_start;
 	
-	int ret;
- 
-    SceNetInitParam initparam;
-    net_memory = malloc(1*1024*1024);
-    initparam.memory = net_memory;
-    initparam.size = NET_INIT_SIZE;
-    initparam.flags = 0;
- 
-    ret = sceNetInit(&initparam);
-    if(ret < 0){ // Error
-        free(net_memory);
-        net_memory = NULL;
-        return -1;
-    } else { // Exit
-        ret = sceNetCtlInit();
-        if (ret < 0 && ret != NET_CTL_ERROR_NOT_TERMINATED){ // Error
-            sceNetTerm();
-            free(net_memory);
-            net_memory = NULL;
-            return -2;
-        }
-    }
-    return 0;
+	if (wall < 1000000)
+		return;
+	idle_cpu_us = (threadCpuTime() - idle_cpu_start) * 1000000 / wall;
+	idleReset();
 }
 
-char* getMac() {	
-	static SceNetEtherAddr mac;
-    //static char mac_string[32];
-	sceNetGetMacAddress(&mac, 0);
+//a footer status, padded with blanks over whatever was longer last time
+void printStatus(FieldPos *pos, const char *text) {
+	int len = strlen(text);
 	
-	sprintf(mac_string, "%02X:%02X:%02X:%02X:%02X:%02X", mac.data[0], mac.data[1], mac.data[2], mac.data[3], mac.data[4], mac.data[5]);
-
-    return mac_string;
+	printf("%-*s", pos->width > len ? pos->width : len, text);
+	pos->width = len;
 }
 
-
-
-/********************* id.dat *********************************/
-void readIDDAT() {	
-	FILE* f1 = fopen("ux0:id.dat", "r");
+void printIdleCost() {
+	char text[48];
 	
-	if (f1 == NULL){
-		printf_color("Error opening ux0:id.dat\n\n\n", RED);
-		
-		if (f1 != NULL) fclose(f1);
+	if (idle_cpu_us < 0) {
+		snprintf(text, sizeof(text), "measuring...");
 	} else {
-		while (fscanf(f1, "%s", buff) == 1) { // expect 1 successful conversion
-			convert_dat(buff);
-		}	
-		fclose(f1);
-	}	
+		snprintf(text, sizeof(text), "%d us per second", idle_cpu_us);
+	}
+	printStatus(&idle_status, text);
 }
-	
-/*****************************************************************************************************************************/
-	
 
-int main() {
-	
-	//initiate buttons
-	SceCtrlData pad;
-	SceCtrlData oldpad;
-	oldpad.buttons = 0;
-	memset(&pad, 0, sizeof(pad));
+void printNetStatus() {
+	char text[96];
 	
-	//initiate screen
-	psvDebugScreenInit();
-	psvDebugScreenSetFgColor(WHITE);	
+	if (snapshot.fields[FIELD_MAC].pending || !snapshot.memo[MEMO_MAC]) {
+		snprintf(text, sizeof(text), "being read in the background...");
+	} else {
+		//net_peak is the pool getMac actually used, the fallback one included
+		snprintf(text, sizeof(text), "read with a %d KiB net pool (%d KiB under the old one), freed right after",
+			snapshot.net_peak / 1024, (NET_POOL_FALLBACK_SIZE - snapshot.net_peak) / 1024);
+	}
+	printStatus(&net_status, text);
+}
 
-	printf_color("PSVident v0.29\n\n\n", GREEN);
+//redraws the values of the tab's fields with volatility in mask, in place
+void redrawFields(int mask) {
+	int i;
+	int x = psvDebugScreenGetX();
+	int y = psvDebugScreenGetY();
+	
+	for (i = 0; i < probe_count; i++) {
+		const ProbeDesc *probe = &probe_table[i];
+		FieldValue *value = &snapshot.fields[probe->id];
+		FieldPos *pos = &field_pos[probe->id];
+		int len = strlen(fieldText(value));
+		
+		if (probe->category != tab || !(probe->volatility & mask) || !probeVisible(&snapshot, probe))
+			continue;
 		
-	//initiate net & save mac in mac_string
-	initnet();
-	getMac();
+		psvDebugScreenSetXY(pos->x, pos->y);
+		printValue(value, pos->width > len ? pos->width : len);
+		pos->width = len;
+	}
+	psvDebugScreenSetXY(idle_status.x, idle_status.y);
+	printIdleCost();
+	psvDebugScreenSetXY(net_status.x, net_status.y);
+	printNetStatus();
+	psvDebugScreenSetXY(x, y);
 	
-	//read ux0:id.dat and save content
-	readIDDAT();
+	drawSparklines();
+}
+
+void refreshReport() {
+	snapshotCollect(&snapshot, PROBE_VOLATILE, CATEGORY_BIT(tab));
+	redrawFields(PROBE_VOLATILE);
+}
 
-	
-	///Vita Model
-	printf("* Vita model:           %s", convert_model(sceKernelGetModelForCDialog()));
-	printf(" (0x%08X)\n", sceKernelGetModelForCDialog()); 
-	
-	///Vita Firmware
-	SceSystemSwVersionParam sw_ver_param;
-	sw_ver_param.size = sizeof(SceSystemSwVersionParam);
-	sceKernelGetSystemSwVersion(&sw_ver_param);
-	
-		//HENkaku version string fix
-		if(strstr(sw_ver_param.version_string, "変革")) {
-			stringReplace(")(変革-", " HENkaku v", sw_ver_param.version_string);
-		}	
-	
-	
-	printf("* Kernel version:       %s %s\n", sw_ver_param.version_string, getMode());
-	printf("\n");
-	
-	///Mac Address
-	printf("* MAC address:          %s\n\n", mac_string);
 
+static SceInt64 ready_us = 0;	//process time when the first report was drawn
+
+void printReportPage() {
+	printf_color("PSVident " PSVIDENT_VERSION "\n\n", GREEN);
+	printTabs();
+	printf("\n\n\n");
 	
-	///ConsoleID / IDPS
-	printf("* IDPS:                 %s\n\n", getCID());
+	printReport();
 	
 	/*VisibleID
 	printf("* Visible ID:           %s\n", getVID());
 	///SMI
 	printf("* SMI:                  %s\n\n", getSMI());*/
 	
-	
 	///Hardware Info 1
 	/*printf("* Hardware Info 1       ");
 	getHardware();
@@ -619,189 +430,260 @@ int main() {
 	getHardware2();
 	printf("\n\n");	*/
 	
+	///show id.dat
+	/*printf("\n\n\n\n\nid.dat\n---------------\n");
+	printf("MID: %s\n", mid );
+	printf("DIG: %s\n", dig );
+	printf("DID: %s\n", did );
+	printf("AID: %s\n", aid );
+	printf("OID: %s\n", oid );
+	printf("SVR: %s\n", svr );*/
 	
-	///free space MemCard/Internal
-	if (vshMemoryCardGetCardInsertState()) {
-		uint64_t free_size = 0, max_size = 0;
-		sceAppMgrGetDevInfo("ux0:", &max_size, &free_size);
-		char free_size_string[16], max_size_string[16];
-			getSizeString(free_size_string, free_size);
-			getSizeString(max_size_string, max_size);
-		printf_color("* ", GREY);
-		
-		if (vshRemovableMemoryGetCardInsertState()) {
-			printf("MemoryCard:           %s / %s\n", free_size_string, max_size_string);
-		} else {
-			printf("Internal Memory:      %s / %s\n", free_size_string, max_size_string);
-		}
-	} else {
-		printf_color("Couldn't find a MemoryCard", RED);
-	}
-	
-	
-	printf("\n\nProcessor(s)\n\n");
-	
-	///Clock Speeds
-	printf_color("* ", YELLOW);
-	printf("ARM Clock frequency:  %d MHz\n", getClockFrequency(0));
-	printf_color("* ", YELLOW);
-	printf("BUS Clock frequency:  %d MHz\n", getClockFrequency(1));
-	/*printf_color("* ", YELLOW);
-	printf("GPU Clock frequency:  %d MHz\n", getClockFrequency(2));*/
-	
-	
-	
-	if ( !vshSblAimgrIsDolce() ) { //scePowerIsBatteryExist() actually doesn't make a difference between Vita/PSTV :|
-		printf("\n\nBattery\n\n");
-	
-		///Battery %
-		printf_color("* ", RED);
-		printf("Battery percentage:   %s\n", getBatteryPercentage());	
+	if (!ready_us)
+		ready_us = sceKernelGetProcessTimeWide();
 	
-		///Battery Capacity
-		printf_color("* ", RED);
-		printf("Battery capacity:     %i/%i mAh\n", getBatteryRemCapacity(), getBatteryCapacity());
+	printf("\n\n\n");
+	//printf("> Press X to make a screenshot\n\n");
+	printf("> Collected in %d ms (%s), report ready %d ms after launch\n\n",
+		(int)(snapshot.collect_us / 1000), serial ? "serial" : "parallel",
+		(int)(ready_us / 1000));
+	printf("> MAC ");
+	psvDebugScreenMarkXY(&net_status.x, &net_status.y);
+	net_status.width = 0;
+	printNetStatus();
+	printf("\n\n");
+	printf("> Values update every %d second(s), press O to update now\n\n", REFRESH_INTERVAL / 1000000);
+	printf("> Main loop CPU time while idle: ");
+	psvDebugScreenMarkXY(&idle_status.x, &idle_status.y);
+	idle_status.width = 0;
+	printIdleCost();
+	printf("\n\n");
+	printf("> Press Square to export the report to %s/ ", EXPORT_DIR);
+	psvDebugScreenMarkXY(&export_status.x, &export_status.y);
+	export_status.width = 0;
+	printf("\n\n");
+	printf("> Each tab is probed the first time it is shown, L/R switch tabs\n\n");
+	printf("> Press Triangle for the startup profile, X for large print\n\n");
+	printf("> Up/Down or the left stick scroll, Left/Right scroll a page\n\n");
+	printf("> Press Select + Start to exit..");
 	
-		///Battery is charging?
-		printf_color("* ", RED);
-		printf("Battery status:       %s\n", getBatteryStatus());
+	//probe failures logged by the workers, under the footer
+	psvDebugScreenFlushLog();
 	
-		///Battery Lifetime
-		printf_color("* ", RED);
-		printf("Battery lifetime:     %i minutes\n", scePowerGetBatteryLifeTime());
-		
-		///Battery Temperature
-		printf_color("* ", RED);
-		if ( getInteger("/CONFIG/SYSTEM", "language") == 1 ) {
-			printf("Battery temperature:  %s Fahrenheit\n", getBatteryTempInFahrenheit());
-		} else {
-			printf("Battery temperature:  %s Celsius\n", getBatteryTempInCelsius());
-		}		
+	drawSparklines();
+}
 
-		///Battery Voltage
-		printf_color("* ", RED);
-		printf("Battery voltage:      %s Volt\n", getBatteryVoltage());
-		
-		///Battery State of Health
-		printf_color("* ", RED);
-		printf("State of Health:      %i%%\n", scePowerGetBatterySOH());					
+void exportNow() {
+	char status[64];
+	int x = psvDebugScreenGetX();
+	int y = psvDebugScreenGetY();
+	SceInt64 start = sceKernelGetProcessTimeWide();
+	int i, ret, len;
+	Color old;
+	
+	//an export is the whole report, tabs nobody looked at included, and
+	//one without the model can't be told apart from a broken one
+	for (i = 0; i < CATEGORY_COUNT; i++) {
+		if (tabVisible(i))
+			collectTab(i);
 	}
-
-	printf("\n\nRegistry/Settings\n\n");
-	
-	///Registry: Vita username
-	/*printf_color("* ", CYAN);
-	printf("username:             ");
-	printf("%s\n", getString("/CONFIG/SYSTEM", "username"));*/
-	
-	///Registry: button_assign
-	printf_color("* ", CYAN);
-	printf("button_assign:        ");
-	printf("%s\n", convert_button_assign(getInteger("/CONFIG/SYSTEM", "button_assign")));
-	
-	///Registry: language
-	printf_color("* ", CYAN);
-	printf("language:             ");
-	printf("%s\n", convert_language(getInteger("/CONFIG/SYSTEM", "language")));
-	
-	///Registry: region_no
-	printf_color("* ", CYAN);
-	printf("region_no:            ");
-	printf("%s\n", getRegionNo()); //reading manually from dreg
-
-	///Registry: suspend_interval
-	printf_color("* ", CYAN);
-	printf("suspend_interval:     ");
-	printf("%i seconds\n", getInteger("/CONFIG/POWER_SAVING", "suspend_interval"));
-	
-	if ( vshSblAimgrIsDolce() ) {
-		///Registry: controller_off_interval
-		printf_color("* ", CYAN);
-		printf("contr_off_interval:   ");
-		printf("%i seconds\n", getInteger("/CONFIG/POWER_SAVING", "controller_off_interval"));	
+	if (!snapshotBackgroundWait(&snapshot, BACKGROUND_TIMEOUT)) {
+		snprintf(status, sizeof(status), "(still reading the MAC, try again)");
+		old = psvDebugScreenSetFgColor(YELLOW);
+	} else if ((ret = exportReport(&snapshot)) < 0) {
+		snprintf(status, sizeof(status), "(failed: 0x%08X)", ret);
+		old = psvDebugScreenSetFgColor(RED);
+	} else {
+		snprintf(status, sizeof(status), "(saved in %d us)", (int)(sceKernelGetProcessTimeWide() - start));
+		old = psvDebugScreenSetFgColor(GREEN);
 	}
 	
-	///Registry: Lockscreen Password
-	/*printf_color("* ", CYAN);
-	printf("lockscreen passcode:  ");
-	printf("%s\n", getString("/SECURITY/SCREEN_LOCK", "passcode"));
-	
-	///Registry: Parental Password
-	printf_color("* ", CYAN);
-	printf("parental passcode:    ");
-	printf("%s\n", getString("/SECURITY/PARENTAL", "passcode"));*/
-	
-	
+	len = strlen(status);
+	psvDebugScreenSetXY(export_status.x, export_status.y);
+	printf("%-*s", export_status.width > len ? export_status.width : len, status);
+	export_status.width = len;
+	psvDebugScreenSetFgColor(old);
+	psvDebugScreenSetXY(x, y);
 	
-	printf("\n\nPSN Account\n\n");
+	drawSparklines();
+}
+
+/********************* large print *********************************/
+
+#define LARGE_SCALE 2
+#define LARGE_LINE 18		//px between large print lines
+#define LARGE_MARGIN 16
+
+//all of it is overlay, like the sparklines, so every frame on this page
+//draws the whole page
+void printLargePage() {
+	int i, y, label_width = 0, w;
+	Color old = psvDebugScreenSetFgColor(GREEN);
 	
-	///id.dat: PSN Username
-	printf_color("* ", GREEN);
-	printf("PSN Nickname:         %s\n", oid);
+	psvDebugScreenDrawText(LARGE_MARGIN, 8, 3, "PSVident " PSVIDENT_VERSION);
+	psvDebugScreenSetFgColor(GREY);
+	psvDebugScreenDrawText(psvDebugScreenGetWidth() - LARGE_MARGIN -
+		psvDebugScreenTextWidth(LARGE_SCALE, category_names[tab]), 12, LARGE_SCALE, category_names[tab]);
 	
-	///Registry: psn email login_id
-	printf_color("* ", GREEN);
-	printf("E-Mail:               ");
-	printf("%s\n", getString("/CONFIG/NP", "login_id"));
+	//values line up after the widest label
+	for (i = 0; i < probe_count; i++) {
+		const ProbeDesc *probe = &probe_table[i];
+		
+		if (probe->category != tab || !probeVisible(&snapshot, probe))
+			continue;
+		w = psvDebugScreenTextWidth(LARGE_SCALE, fieldLabel(probe));
+		if (w > label_width)
+			label_width = w;
+	}
 	
-	///Registry: psn account password
-	printf_color("* ", GREEN);
-	printf("password:             ");
-	printf("%s\n", getString("/CONFIG/NP", "password"));
+	y = 44;
+	for (i = 0; i < probe_count && y + LARGE_LINE <= psvDebugScreenGetHeight() - 24; i++) {
+		const ProbeDesc *probe = &probe_table[i];
+		FieldValue *value = &snapshot.fields[probe->id];
+		
+		if (probe->category != tab || !probeVisible(&snapshot, probe))
+			continue;
+		
+		psvDebugScreenSetFgColor(probe->color);
+		psvDebugScreenDrawText(LARGE_MARGIN, y, LARGE_SCALE, fieldLabel(probe));
+		psvDebugScreenSetFgColor(value->pending ? GREY : value->error < 0 ? RED : WHITE);
+		psvDebugScreenDrawText(LARGE_MARGIN + label_width + LARGE_MARGIN, y, LARGE_SCALE, fieldText(value));
+		y += LARGE_LINE;
+	}
 	
-	///id.dat: PSID
-	printf_color("* ", GREEN);
-	printf("PSID:                 %s\n", did);
+	psvDebugScreenSetFgColor(WHITE);
+	psvDebugScreenDrawText(LARGE_MARGIN, psvDebugScreenGetHeight() - 16, 1, "> Press X to go back, L/R to switch tabs");
+	psvDebugScreenSetFgColor(old);
+}
+
+#define PROFILE_BAR_WIDTH 60
+
+void printProfilePage() {
+	const ProfileSpan *spans;
+	int count = profileSpans(&spans);
+	SceInt64 total = 1;
+	int i, col, from, to;
 	
-	///id.dat: account_id 
-	printf_color("* ", GREEN);
-	printf("account_id:           ");
-		//printf("%s\n", getBin("/CONFIG/NP", "account_id"));
-	int i; ///reading and inversing from id.dat
-	for (i = strlen(aid) - 1; i >= 0; i = i - 2){
-		printf("%c", aid[i-1]);
-		printf("%c", aid[i]);
-	} printf("\n");
+	for (i = 0; i < count; i++) {
+		if (spans[i].end > total)
+			total = spans[i].end;
+	}
 	
+	printf_color("Startup profile\n\n", GREEN);
+	printf("  %-22s %-8s %9s %9s\n", "phase", "lane", "start us", "cost us");
 	
-	///Registry: psn region
-	printf_color("* ", GREEN);
-	printf("region:               ");
-	printf("%s\n", getString("/CONFIG/NP", "country"));
+	for (i = 0; i < count; i++) {
+		const ProfileSpan *span = &spans[i];
+		
+		printf_color(span->critical ? "* " : "  ", YELLOW);
+		printf("%-22.22s %-8s %9lld %9lld ", span->name, profileLaneName(span->lane),
+			span->start, span->end - span->start);
+		
+		//where the span sits on the launch timeline
+		from = span->start * PROFILE_BAR_WIDTH / total;
+		to = span->end * PROFILE_BAR_WIDTH / total;
+		if (to == from)
+			to++;
+		for (col = 0; col < to; col++)
+			printf(col < from ? " " : "#");
+		printf("\n");
+	}
 	
+	printf("\n");
+	printf_color("* ", YELLOW);
+	printf("on the critical path, also saved to %s\n\n\n", PROFILE_PATH);
+	printf("> Press Triangle to go back");
+}
+
+enum {
+	PAGE_REPORT,
+	PAGE_PROFILE,
+	PAGE_LARGE
+};
+
+void showPage(int page) {
+	psvDebugScreenBeginFrame();
+	psvDebugScreenClear(BLACK);
+	switch (page) {
+		case PAGE_PROFILE: printProfilePage(); break;
+		case PAGE_LARGE: printLargePage(); break;
+		default: printReportPage(); break;
+	}
+	psvDebugScreenEndFrame();
+}
+
 	
-	///testing
-	/*printf("\n\n");
-	printf("vshSblAimgrIsCEX():           %i\n", vshSblAimgrIsCEX());	
-	printf("vshSblAimgrIsDEX():           %i\n", vshSblAimgrIsDEX());	
-	printf("vshSblAimgrIsDolce():         %i\n", vshSblAimgrIsDolce());	
-	printf("vshSblAimgrIsGenuineDolce():  %i\n", vshSblAimgrIsGenuineDolce());	
-	printf("vshSblAimgrIsGenuineVITA():   %i\n", vshSblAimgrIsGenuineVITA());	
-	printf("vshSblAimgrIsTest():          %i\n", vshSblAimgrIsTest());	
-	printf("vshSblAimgrIsTool():          %i\n", vshSblAimgrIsTool());	
-	printf("vshSblAimgrIsVITA():          %i\n", vshSblAimgrIsVITA());	
+/*****************************************************************************************************************************/
 	
-	printf("vshSysconIsIduMode():         %i\n", vshSysconIsIduMode());
-	printf("vshSysconIsShowMode():        %i\n", vshSysconIsShowMode());*/
 
+int main() {
 	
-	///show id.dat
-	/*printf("\n\n\n\n\nid.dat\n---------------\n");
-	printf("MID: %s\n", mid );
-	printf("DIG: %s\n", dig );
-	printf("DID: %s\n", did );
-	printf("AID: %s\n", aid );
-	printf("OID: %s\n", oid );
-	printf("SVR: %s\n", svr );*/
+	//initiate buttons
+	SceCtrlData pad;
+	SceCtrlData oldpad;
+	oldpad.buttons = 0;
+	memset(&pad, 0, sizeof(pad));
+	int page = PAGE_REPORT;
+	int span;
+	ScrollInput scroll;
+	int lines;
+	int reading = 1;	//background collect not seen finished yet
 	
-	printf("\n\n\n");
-	//printf("> Press X to make a screenshot\n\n");
-	printf("> Press O to update values\n\n");
-	printf("> Press Select + Start to exit..");
-		
-		
+	//the stick scrolls too
+	sceCtrlSetSamplingMode(SCE_CTRL_MODE_ANALOG);
+	
+	//initiate screen
+	span = profileBegin("psvDebugScreenInit", LANE_MAIN);
+	psvDebugScreenInit();
+	psvDebugScreenSetPageRows(REPORT_ROWS);
+	psvDebugScreenLoadFont(FONT_PATH);
+	psvDebugScreenSetFgColor(WHITE);	
+	profileEnd(span);
+
+	//only the first tab is probed before anything is drawn, the others
+	//when they are first shown. Independent groups run on worker threads;
+	//hold L at launch to probe one after another instead, for comparing
+	//startup times. A held L is no tab switch.
+	sceCtrlPeekBufferPositive(0, &pad, 1);
+	serial = pad.buttons & SCE_CTRL_LTRIGGER;
+	oldpad = pad;
+	
+	span = profileBegin("collect", LANE_MAIN);
+	snapshotInit(&snapshot);
+	//the model and MAC need the net stack loaded, the tab doesn't wait
+	if (!serial)
+		snapshotCollectBackground(&snapshot, GROUP_NET, PROBE_ALL, CATEGORY_BIT(CATEGORY_DEVICE));
+	collectTab(CATEGORY_DEVICE);
+	profileEnd(span);
+
+	//draw the whole report off screen and show it in one go
+	span = profileBegin("first draw", LANE_MAIN);
+	psvDebugScreenBeginFrame();
+	printReportPage();
+	psvDebugScreenEndFrame();
+	profileEnd(span);
+	
+	//the refresh loop isn't startup, stop recording. The background read
+	//still holds spans, so it ends first; the report is up by now
+	snapshotBackgroundWait(&snapshot, BACKGROUND_TIMEOUT);
+	profileStop();
+	profileWrite(PROFILE_PATH);
+	
+	SceInt64 next_refresh = sceKernelGetProcessTimeWide() + REFRESH_INTERVAL;
+	unsigned pressed;
+	
+	//a screen less two rows, so a line of context stays in view
+	scrollInit(&scroll, psvDebugScreenGetHeight() / TEXT_LINE - 2);
+	idleReset();
 	while (1) {
-		sceCtrlPeekBufferPositive(0, &pad, 1);
+		//blocks until the next controller sample, one per vblank, so the
+		//loop sleeps between frames instead of spinning on a Peek and
+		//heating up the battery it reports on. Work only happens on
+		//input or when a refresh is due.
+		sceCtrlReadBufferPositive(0, &pad, 1);
+		pressed = pad.buttons & ~oldpad.buttons;
+		if (pad.buttons != oldpad.buttons)
+			idleReset();
 		
 		///make Screenshot
 		/*if (pad.buttons != oldpad.buttons) {
@@ -822,13 +704,75 @@ int main() {
 			}	
 		}*/
 		
-		///self reloading
-		if (pad.buttons != oldpad.buttons) {
-			if (pad.buttons & SCE_CTRL_CIRCLE) {
-				sceAppMgrLoadExec("app0:/eboot.bin", NULL, NULL);
+		///startup profile and large print pages, the same button goes back
+		if (pressed & (SCE_CTRL_TRIANGLE | SCE_CTRL_CROSS)) {
+			int next = (pressed & SCE_CTRL_TRIANGLE) ? PAGE_PROFILE : PAGE_LARGE;
+			page = page == next ? PAGE_REPORT : next;
+			showPage(page);
+		}
+		
+		///tabs, probed the first time they are shown
+		if (page != PAGE_PROFILE && (pressed & (SCE_CTRL_LTRIGGER | SCE_CTRL_RTRIGGER))) {
+			tab = nextTab((pressed & SCE_CTRL_LTRIGGER) ? -1 : 1);
+			collectTab(tab);
+			showPage(page);
+		}
+		
+		///model and MAC, once the background read is in
+		if (reading && snapshotBackgroundDone(&snapshot)) {
+			reading = 0;
+			if (page != PAGE_PROFILE) {
+				psvDebugScreenBeginFrame();
+				if (page == PAGE_LARGE) {
+					printLargePage();
+				} else {
+					redrawFields(PROBE_ALL);
+				}
+				psvDebugScreenEndFrame();
+			}
+		}
+		
+		///scrolling, the report and the profile can be longer than the screen
+		lines = scrollUpdate(&scroll, &pad, sceKernelGetProcessTimeWide());
+		if (lines && page != PAGE_LARGE) {
+			psvDebugScreenBeginFrame();
+			psvDebugScreenSetView(psvDebugScreenGetView() + lines * TEXT_LINE);
+			if (page == PAGE_REPORT)
+				drawSparklines();
+			psvDebugScreenEndFrame();
+			idleReset();
+		}
+		
+		///export
+		if (page == PAGE_REPORT && (pressed & SCE_CTRL_SQUARE)) {
+			psvDebugScreenBeginFrame();
+			exportNow();
+			psvDebugScreenEndFrame();
+		}
+		
+		///live values, on a timer or on demand
+		if (page != PAGE_PROFILE && ((pressed & SCE_CTRL_CIRCLE) ||
+				sceKernelGetProcessTimeWide() >= next_refresh)) {
+			idleMeasure();
+			psvDebugScreenBeginFrame();
+			if (page == PAGE_LARGE) {
+				snapshotCollect(&snapshot, PROBE_VOLATILE, CATEGORY_BIT(tab));
+				printLargePage();
+			} else {
+				refreshReport();
 			}
-		}	
+			psvDebugScreenEndFrame();
+			next_refresh = sceKernelGetProcessTimeWide() + REFRESH_INTERVAL;
+		}
 
+		///log records queued by other threads since the last frame
+		if (page == PAGE_REPORT && logqReady()) {
+			psvDebugScreenBeginFrame();
+			psvDebugScreenFlushLog();
+			drawSparklines();
+			psvDebugScreenEndFrame();
+		}
+		
 		///exit combo
 		if (pad.buttons & SCE_CTRL_SELECT && pad.buttons & SCE_CTRL_START)
 			break;
@@ -836,6 +780,7 @@ int main() {
 		oldpad = pad;
 	}
 
+	batteryStop();
 	sceKernelExitProcess(0);
 	return 0;
 }
@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <psp2/io/stat.h>
+#include <psp2/kernel/processmgr.h>
+#include <psp2/kernel/threadmgr.h>
+
+#include "profile.h"
+#include "snapshot.h"
+
+static ProfileSpan spans[PROFILE_MAX_SPANS];
+static int span_count = 0;
+static ProfileSpan sorted[PROFILE_MAX_SPANS];	// what profileSpans hands out
+static int sorted_count = 0;
+static int stopped = 0;
+static int finished = 0;
+
+int profileBegin(const char *name, int lane) {
+	int span;
+
+	if (stopped)
+		return -1;
+
+	span = __sync_fetch_and_add(&span_count, 1);
+	if (span >= PROFILE_MAX_SPANS)
+		return -1;
+
+	spans[span].name = name;
+	spans[span].lane = lane;
+	spans[span].critical = 0;
+	spans[span].start = sceKernelGetProcessTimeWide();
+	__atomic_store_n(&spans[span].end, 0, __ATOMIC_RELEASE);
+	return span;
+}
+
+// end is the one field another thread may read while it changes (a span
+// still open when the profile is written), 64-bit stores aren't atomic on
+// ARM otherwise
+void profileEnd(int span) {
+	if (span >= 0)
+		__atomic_store_n(&spans[span].end, sceKernelGetProcessTimeWide(), __ATOMIC_RELEASE);
+}
+
+void profileStop() {
+	stopped = 1;
+}
+
+const char* profileLaneName(int lane) {
+	if (lane == LANE_MAIN)
+		return "main";
+	return group_names[lane - 1];
+}
+
+static int compareStart(const void *a, const void *b) {
+	const ProfileSpan *x = a, *y = b;
+
+	if (x->start != y->start)
+		return x->start < y->start ? -1 : 1;
+	return x->end > y->end ? -1 : x->end < y->end;	//enclosing span first
+}
+
+// The main thread is always on the critical path; of the workers, only the
+// one that finished last held up the join. Works on a copy, a thread still
+// inside a span ends it in spans[] later; spans open at this point are left out.
+static void finish() {
+	SceInt64 last_end = 0;
+	int last_lane = -1;
+	int i, count = span_count < PROFILE_MAX_SPANS ? span_count : PROFILE_MAX_SPANS;
+
+	sorted_count = 0;
+	for (i = 0; i < count; i++) {
+		SceInt64 end = __atomic_load_n(&spans[i].end, __ATOMIC_ACQUIRE);
+
+		if (end != 0) {
+			sorted[sorted_count].name = spans[i].name;
+			sorted[sorted_count].lane = spans[i].lane;
+			sorted[sorted_count].start = spans[i].start;
+			sorted[sorted_count++].end = end;
+		}
+	}
+
+	for (i = 0; i < sorted_count; i++) {
+		if (sorted[i].lane != LANE_MAIN && sorted[i].end > last_end) {
+			last_end = sorted[i].end;
+			last_lane = sorted[i].lane;
+		}
+	}
+	for (i = 0; i < sorted_count; i++)
+		sorted[i].critical = sorted[i].lane == LANE_MAIN || sorted[i].lane == last_lane;
+
+	qsort(sorted, sorted_count, sizeof(ProfileSpan), compareStart);
+	finished = 1;
+}
+
+int profileSpans(const ProfileSpan **out) {
+	stopped = 1;
+	if (!finished)
+		finish();
+
+	*out = sorted;
+	return sorted_count;
+}
+
+// appends, so cold and warm launches end up next to each other; the uptime
+// tells them apart (the first launch after boot is the cold one)
+int profileWrite(const char *path) {
+	const ProfileSpan *list;
+	int i, count = profileSpans(&list);
+	FILE *fp;
+
+	sceIoMkdir("ux0:data/PSVident", 0777);
+	fp = fopen(path, "a");
+	if (fp == NULL)
+		return -1;
+
+	fprintf(fp, "launch at uptime %llu ms\n", (unsigned long long)(sceKernelGetSystemTimeWide() / 1000));
+	fprintf(fp, "%-24s %-8s %10s %10s\n", "phase", "lane", "start_us", "cost_us");
+	for (i = 0; i < count; i++) {
+		fprintf(fp, "%-24s %-8s %10lld %10lld%s\n", list[i].name, profileLaneName(list[i].lane),
+			list[i].start, list[i].end - list[i].start, list[i].critical ? " *" : "");
+	}
+	fprintf(fp, "\n");
+
+	fclose(fp);
+	return 0;
+}
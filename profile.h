@@ -0,0 +1,32 @@
+#pragma once
+
+#include <psp2/types.h>
+
+// Startup profiler: timestamped spans from sceKernelGetProcessTimeWide,
+// recorded until profileStop() so the refresh loop doesn't flood it.
+// Begin/End may be called from any thread.
+
+#define PROFILE_MAX_SPANS 128
+#define PROFILE_PATH "ux0:data/PSVident/profile.txt"
+
+enum {
+	LANE_MAIN = 0,	// the main thread; probe workers use 1 + their group
+};
+
+typedef struct {
+	const char *name;
+	int lane;
+	int critical;	// on the path that decided when the report was ready
+	SceInt64 start, end;	// us since launch
+} ProfileSpan;
+
+// returns a handle for profileEnd, -1 once stopped or full
+int profileBegin(const char *name, int lane);
+void profileEnd(int span);
+void profileStop();
+
+// sorted by start time, with the critical path marked
+int profileSpans(const ProfileSpan **spans);
+const char* profileLaneName(int lane);
+
+int profileWrite(const char *path);
@@ -0,0 +1,98 @@
+#include <string.h>
+
+#include "registry.h"
+
+#define CACHE_SIZE 64	// power of two
+
+typedef struct {
+	const char *path;	// NULL: free slot
+	const char *key;
+	RegType type;
+	int error;
+	int value;
+	char string[REG_STRING_SIZE];
+} CacheEntry;
+
+static CacheEntry cache[CACHE_SIZE];
+static int cache_used = 0;
+
+static unsigned hashKey(const char *path, const char *key) {
+	unsigned hash = 2166136261u;
+
+	for (; *path; path++)
+		hash = (hash ^ (unsigned char)*path) * 16777619u;
+	for (; *key; key++)
+		hash = (hash ^ (unsigned char)*key) * 16777619u;
+	return hash;
+}
+
+// the entry for path/key, or the free slot it would go in; NULL when full
+static CacheEntry *findSlot(const char *path, const char *key, RegType type) {
+	unsigned slot = hashKey(path, key) & (CACHE_SIZE - 1);
+	int probes;
+
+	for (probes = 0; probes < CACHE_SIZE; probes++) {
+		CacheEntry *entry = &cache[slot];
+
+		if (entry->path == NULL)
+			return entry;
+		if (entry->type == type && strcmp(entry->key, key) == 0 && strcmp(entry->path, path) == 0)
+			return entry;
+		slot = (slot + 1) & (CACHE_SIZE - 1);
+	}
+	return NULL;
+}
+
+static void fetch(RegQuery *query, CacheEntry *entry) {
+	if (query->type == REG_INT) {
+		entry->value = -1;
+		entry->error = sceRegMgrGetKeyInt(query->path, query->key, &entry->value);
+	} else {
+		entry->string[0] = '\0';
+		entry->error = sceRegMgrGetKeyStr(query->path, query->key, entry->string, sizeof(entry->string));
+		entry->string[sizeof(entry->string) - 1] = '\0';
+	}
+}
+
+static void answer(RegQuery *query, const CacheEntry *entry) {
+	query->error = entry->error;
+	if (query->type == REG_INT) {
+		query->value = entry->value;
+	} else if (query->size > 0) {
+		strncpy(query->string, entry->string, query->size - 1);
+		query->string[query->size - 1] = '\0';
+	}
+}
+
+int regGetBatch(RegQuery *queries, int count) {
+	CacheEntry scratch, *entry;
+	int i, failed = 0;
+
+	for (i = 0; i < count; i++) {
+		RegQuery *query = &queries[i];
+
+		entry = findSlot(query->path, query->key, query->type);
+		if (entry == NULL || entry->path == NULL) {
+			//a miss, cached unless the cache is full
+			if (entry == NULL || cache_used >= CACHE_SIZE / 2)
+				entry = &scratch;
+			else
+				cache_used++;
+
+			fetch(query, entry);
+			entry->path = query->path;
+			entry->key = query->key;
+			entry->type = query->type;
+		}
+
+		answer(query, entry);
+		if (query->error < 0)
+			failed++;
+	}
+	return failed;
+}
+
+void regCacheClear() {
+	memset(cache, 0, sizeof(cache));
+	cache_used = 0;
+}
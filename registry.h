@@ -0,0 +1,31 @@
+#pragma once
+
+// sceRegMgr reads through a per-session cache. Registry values PSVident
+// shows don't change while it runs, so every key is fetched at most once;
+// failures are cached too. Not thread-safe, callers share one thread.
+
+int sceRegMgrGetKeyInt(const char* reg, const char* key, int* val);
+int sceRegMgrGetKeyStr(const char* reg, const char* key, char* str, const int buf_size);
+
+#define REG_STRING_SIZE 128
+
+typedef enum {
+	REG_INT,
+	REG_STRING,
+} RegType;
+
+typedef struct {
+	const char *path;	// kept by the cache, use string literals
+	const char *key;
+	RegType type;
+
+	int error;			// out: sceRegMgr result, < 0 on failure
+	int value;			// out: REG_INT
+	char *string;		// REG_STRING: caller storage
+	int size;
+} RegQuery;
+
+// fills every query in one pass, misses go to sceRegMgr; returns how many failed
+int regGetBatch(RegQuery *queries, int count);
+
+void regCacheClear();
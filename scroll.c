@@ -0,0 +1,87 @@
+#include <string.h>
+
+#include "scroll.h"
+
+#define REPEAT_DELAY 400000		// us held before a button repeats
+#define REPEAT_INTERVAL 50000	// us between repeats
+#define ACCEL_TIME 300000		// us of repeating per extra line a step
+#define MAX_STEP 8				// lines a repeat at full speed
+
+#define STICK_DEADZONE 32
+#define STICK_RANGE (128 - STICK_DEADZONE)
+#define STICK_SPEED 120			// lines per second at full tilt
+#define MAX_GAP 100000			// us, a stalled loop doesn't make the view jump
+
+void scrollInit(ScrollInput *in, int page) {
+	memset(in, 0, sizeof(*in));
+	in->page = page;
+}
+
+static int buttonStep(ScrollInput *in, unsigned buttons, SceInt64 now) {
+	int dir = 0, paging = 0, step;
+	SceInt64 repeating;
+
+	if (buttons & SCE_CTRL_UP)
+		dir--;
+	if (buttons & SCE_CTRL_DOWN)
+		dir++;
+	if (!dir) {
+		paging = 1;
+		if (buttons & SCE_CTRL_LEFT)
+			dir--;
+		if (buttons & SCE_CTRL_RIGHT)
+			dir++;
+	}
+
+	//a new press moves at once, then waits before it repeats
+	if (dir != in->held || paging != in->paging) {
+		in->held = dir;
+		in->paging = paging;
+		in->held_since = now;
+		in->next_repeat = now + REPEAT_DELAY;
+		return dir * (paging ? in->page : 1);
+	}
+	if (!dir || now < in->next_repeat)
+		return 0;
+
+	//one repeat per sample at most, missed ones are not made up for
+	in->next_repeat += REPEAT_INTERVAL;
+	if (in->next_repeat < now)
+		in->next_repeat = now + REPEAT_INTERVAL;
+
+	if (paging)
+		return dir * in->page;
+	repeating = now - in->held_since - REPEAT_DELAY;
+	step = 1 + repeating / ACCEL_TIME;
+	return dir * (step < MAX_STEP ? step : MAX_STEP);
+}
+
+static int stickStep(ScrollInput *in, int ly, SceInt64 gap) {
+	int d = ly - 128;
+	int lines;
+
+	if (d > -STICK_DEADZONE && d < STICK_DEADZONE) {
+		in->stick_frac = 0;
+		return 0;
+	}
+	d += d < 0 ? STICK_DEADZONE : -STICK_DEADZONE;
+
+	//speed goes with the square of the tilt, slow near the dead zone
+	in->stick_frac += (long long)d * (d < 0 ? -d : d) * STICK_SPEED * 256 * gap /
+		((long long)STICK_RANGE * STICK_RANGE * 1000000);
+	lines = in->stick_frac / 256;
+	in->stick_frac -= lines * 256;
+	return lines;
+}
+
+int scrollUpdate(ScrollInput *in, const SceCtrlData *pad, SceInt64 now) {
+	SceInt64 gap = in->last ? now - in->last : 0;
+
+	if (gap < 0)
+		gap = 0;
+	if (gap > MAX_GAP)
+		gap = MAX_GAP;
+	in->last = now;
+
+	return buttonStep(in, pad->buttons, now) + stickStep(in, pad->ly, gap);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <psp2/types.h>
+#include <psp2/ctrl.h>
+
+// Scrolling input: up/down move a line, left/right a page, both repeat
+// while held and lines speed up the longer they are held. The left stick
+// scrolls smoothly, faster the further it is pushed. Needs the controller
+// in SCE_CTRL_MODE_ANALOG for the stick.
+
+typedef struct {
+	int page;				// lines moved by left/right
+	int held;				// d-pad direction held, -1 up, 1 down, 0 none
+	int paging;				// held on left/right rather than up/down
+	SceInt64 held_since;
+	SceInt64 next_repeat;
+	SceInt64 last;			// time of the previous sample
+	int stick_frac;			// stick motion short of a line, 1/256 lines
+} ScrollInput;
+
+void scrollInit(ScrollInput *in, int page);
+
+// lines to move for this controller sample, positive is down
+int scrollUpdate(ScrollInput *in, const SceCtrlData *pad, SceInt64 now);
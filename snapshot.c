@@ -0,0 +1,605 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <psp2/appmgr.h>
+#include <psp2/power.h>
+#include <psp2/kernel/processmgr.h>
+#include <psp2/kernel/threadmgr.h>
+
+#include "battery.h"
+#include "profile.h"
+#include "snapshot.h"
+#include "sysinfo.h"
+
+const char *category_names[CATEGORY_COUNT] = {
+	"Identity",
+	"Processor(s)",
+	"Battery",
+	"Registry/Settings",
+	"PSN Account",
+};
+
+// machine-readable names for exports, stable across label changes
+const char *category_keys[CATEGORY_COUNT] = {
+	"device",
+	"processor",
+	"battery",
+	"registry",
+	"psn",
+};
+
+const char *field_keys[FIELD_COUNT] = {
+	[FIELD_MODEL]                   = "model",
+	[FIELD_FIRMWARE]                = "firmware",
+	[FIELD_MAC]                     = "mac",
+	[FIELD_IDPS]                    = "idps",
+	[FIELD_STORAGE]                 = "storage",
+	[FIELD_ARM_CLOCK]               = "arm_clock",
+	[FIELD_BUS_CLOCK]               = "bus_clock",
+	[FIELD_BATTERY_PERCENT]         = "battery_percent",
+	[FIELD_BATTERY_CAPACITY]        = "battery_capacity",
+	[FIELD_BATTERY_STATUS]          = "battery_status",
+	[FIELD_BATTERY_LIFETIME]        = "battery_lifetime",
+	[FIELD_BATTERY_TEMP]            = "battery_temp",
+	[FIELD_BATTERY_VOLTAGE]         = "battery_voltage",
+	[FIELD_BATTERY_SOH]             = "battery_soh",
+	[FIELD_BATTERY_DRAIN]           = "battery_drain",
+	[FIELD_BUTTON_ASSIGN]           = "button_assign",
+	[FIELD_LANGUAGE]                = "language",
+	[FIELD_REGION]                  = "region_no",
+	[FIELD_SUSPEND_INTERVAL]        = "suspend_interval",
+	[FIELD_CONTROLLER_OFF_INTERVAL] = "controller_off_interval",
+	[FIELD_PSN_NICKNAME]            = "psn_nickname",
+	[FIELD_PSN_EMAIL]               = "psn_email",
+	[FIELD_PSN_PASSWORD]            = "psn_password",
+	[FIELD_PSID]                    = "psid",
+	[FIELD_ACCOUNT_ID]              = "account_id",
+	[FIELD_PSN_REGION]              = "psn_region",
+};
+
+const char *group_names[GROUP_COUNT] = {
+	"net",
+	"files",
+	"registry",
+	"power",
+};
+
+/********************* memoized facts *********************************/
+
+static int memoModel(SystemSnapshot *snap) {
+	if (!snap->memo[MEMO_MODEL]) {
+		snap->model = sceKernelGetModelForCDialog();
+		snap->memo[MEMO_MODEL] = 1;
+	}
+	return snap->model;
+}
+
+static int memoDolce(SystemSnapshot *snap) {
+	if (!snap->memo[MEMO_DOLCE]) {
+		snap->is_dolce = vshSblAimgrIsDolce();
+		snap->memo[MEMO_DOLCE] = 1;
+	}
+	return snap->is_dolce;
+}
+
+static int memoLanguage(SystemSnapshot *snap) {
+	if (!snap->memo[MEMO_LANGUAGE]) {
+		snap->language = getInteger("/CONFIG/SYSTEM", "language", &snap->language_ret);
+		snap->memo[MEMO_LANGUAGE] = 1;
+	}
+	return snap->language;
+}
+
+static const char *memoMac(SystemSnapshot *snap) {
+	if (!snap->memo[MEMO_MAC]) {
+		int span = profileBegin("getMac", snap->lane[GROUP_NET]);
+		snap->mac_ret = getMac(snap->mac, &snap->net_peak);
+		profileEnd(span);
+		snap->memo[MEMO_MAC] = 1;
+	}
+	return snap->mac;
+}
+
+static int memoIdDat(SystemSnapshot *snap) {
+	if (!snap->memo[MEMO_ID_DAT]) {
+		int span = profileBegin("readIDDAT", snap->lane[GROUP_FILES]);
+		snap->id_dat_ret = readIDDAT();
+		profileEnd(span);
+		//the known values still show, the file gets a note like it used to
+		if (snap->id_dat_ret == 1)
+			psvDebugScreenLog(RED, "\n! %s/id.dat wrongly formatted?", group_names[GROUP_FILES]);
+		snap->memo[MEMO_ID_DAT] = 1;
+	}
+	return snap->id_dat_ret;
+}
+
+/********************* probes *********************************/
+
+static void setError(FieldValue *value, int error, const char *format, int code) {
+	value->error = error;
+	snprintf(value->text, sizeof(value->text), format, code);
+}
+
+static int isVita(SystemSnapshot *snap) {
+	//scePowerIsBatteryExist() actually doesn't make a difference between Vita/PSTV :|
+	return !memoDolce(snap);
+}
+
+static int isDolce(SystemSnapshot *snap) {
+	return memoDolce(snap);
+}
+
+static void fetchModel(SystemSnapshot *snap, FieldValue *value) {
+	int model = memoModel(snap);
+	snprintf(value->text, sizeof(value->text), "%s (0x%08X)", convert_model(model, memoMac(snap)), model);
+}
+
+static void fetchFirmware(SystemSnapshot *snap, FieldValue *value) {
+	SceSystemSwVersionParam sw_ver_param;
+	char version[64];
+
+	sw_ver_param.size = sizeof(SceSystemSwVersionParam);
+	sceKernelGetSystemSwVersion(&sw_ver_param);
+
+	//HENkaku version string fix, done on a copy as it can grow. The screen
+	//can show 変革 now; this keeps reports and exports in one format
+	snprintf(version, sizeof(version), "%s", (char *)sw_ver_param.version_string);
+	if(strstr(version, "変革")) {
+		stringReplace(")(変革-", " HENkaku v", version);
+	}
+
+	snprintf(value->text, sizeof(value->text), "%s %s", version, getMode());
+}
+
+static void fetchMac(SystemSnapshot *snap, FieldValue *value) {
+	memoMac(snap);
+	if (snap->mac_ret < 0) {
+		setError(value, snap->mac_ret, "Failed to read MAC: 0x%x", snap->mac_ret);
+		return;
+	}
+	snprintf(value->text, sizeof(value->text), "%s", snap->mac);
+}
+
+static void fetchIDPS(SystemSnapshot *snap, FieldValue *value) {
+	getCID(value->text);
+}
+
+static void fetchStorage(SystemSnapshot *snap, FieldValue *value) {
+	uint64_t free_size = 0, max_size = 0;
+	char free_size_string[16], max_size_string[16];
+
+	if (!vshMemoryCardGetCardInsertState()) {
+		value->label = "MemoryCard:";
+		setError(value, -1, "Couldn't find a MemoryCard", 0);
+		return;
+	}
+
+	if (vshRemovableMemoryGetCardInsertState()) {
+		value->label = "MemoryCard:";
+	} else {
+		value->label = "Internal Memory:";
+	}
+
+	sceAppMgrGetDevInfo("ux0:", &max_size, &free_size);
+	getSizeString(free_size_string, free_size);
+	getSizeString(max_size_string, max_size);
+	snprintf(value->text, sizeof(value->text), "%s / %s", free_size_string, max_size_string);
+}
+
+static void fetchArmClock(SystemSnapshot *snap, FieldValue *value) {
+	snprintf(value->text, sizeof(value->text), "%d MHz", getClockFrequency(0));
+}
+
+static void fetchBusClock(SystemSnapshot *snap, FieldValue *value) {
+	snprintf(value->text, sizeof(value->text), "%d MHz", getClockFrequency(1));
+}
+
+static void fetchBatteryPercent(SystemSnapshot *snap, FieldValue *value) {
+	getBatteryPercentage(value->text);
+}
+
+static void fetchBatteryCapacity(SystemSnapshot *snap, FieldValue *value) {
+	snprintf(value->text, sizeof(value->text), "%i/%i mAh", getBatteryRemCapacity(), getBatteryCapacity());
+}
+
+static void fetchBatteryStatus(SystemSnapshot *snap, FieldValue *value) {
+	snprintf(value->text, sizeof(value->text), "%s", getBatteryStatus());
+}
+
+static void fetchBatteryLifetime(SystemSnapshot *snap, FieldValue *value) {
+	snprintf(value->text, sizeof(value->text), "%i minutes", scePowerGetBatteryLifeTime());
+}
+
+static void fetchBatteryTemp(SystemSnapshot *snap, FieldValue *value) {
+	char temp[24];
+
+	if ( memoLanguage(snap) == 1 ) {
+		getBatteryTempInFahrenheit(temp);
+		snprintf(value->text, sizeof(value->text), "%s Fahrenheit", temp);
+	} else {
+		getBatteryTempInCelsius(temp);
+		snprintf(value->text, sizeof(value->text), "%s Celsius", temp);
+	}
+}
+
+static void fetchBatteryVoltage(SystemSnapshot *snap, FieldValue *value) {
+	char voltage[24];
+
+	getBatteryVoltage(voltage);
+	snprintf(value->text, sizeof(value->text), "%s Volt", voltage);
+}
+
+static void fetchBatterySOH(SystemSnapshot *snap, FieldValue *value) {
+	snprintf(value->text, sizeof(value->text), "%i%%", scePowerGetBatterySOH());
+}
+
+// from the background sampler, see battery.c
+static void fetchBatteryDrain(SystemSnapshot *snap, FieldValue *value) {
+	BatteryTickStats stats;
+	int drain, len;
+
+	if (batteryDrainRate(&drain) < 0)
+		len = snprintf(value->text, sizeof(value->text), "measuring...");
+	else
+		len = snprintf(value->text, sizeof(value->text), "%d mAh/h", drain);
+
+	batteryTickStats(&stats);
+	if (stats.ticks)
+		snprintf(value->text + len, sizeof(value->text) - len, " (sampled in %u us)",
+			(unsigned)(stats.total_us / stats.ticks));
+}
+
+static void fetchRegistryInt(FieldValue *value, const char *location, const char *key, const char *format) {
+	int ret;
+	int val = getInteger(location, key, &ret);
+
+	if (ret < 0) {
+		setError(value, ret, "Failed to GetKeyInt: 0x%x", ret);
+		return;
+	}
+	snprintf(value->text, sizeof(value->text), format, val);
+}
+
+static void fetchRegistryStr(FieldValue *value, const char *location, const char *key) {
+	int ret = getString(location, key, value->text, sizeof(value->text));
+
+	if (ret < 0)
+		setError(value, ret, "Failed to GetKeyStr: 0x%x", ret);
+}
+
+static void fetchButtonAssign(SystemSnapshot *snap, FieldValue *value) {
+	int ret;
+	int val = getInteger("/CONFIG/SYSTEM", "button_assign", &ret);
+
+	if (ret < 0) {
+		setError(value, ret, "Failed to GetKeyInt: 0x%x", ret);
+		return;
+	}
+	snprintf(value->text, sizeof(value->text), "%s", convert_button_assign(val));
+}
+
+static void fetchLanguage(SystemSnapshot *snap, FieldValue *value) {
+	int language = memoLanguage(snap);
+
+	if (snap->language_ret < 0) {
+		setError(value, snap->language_ret, "Failed to GetKeyInt: 0x%x", snap->language_ret);
+		return;
+	}
+	snprintf(value->text, sizeof(value->text), "%s", convert_language(language));
+}
+
+static void fetchRegion(SystemSnapshot *snap, FieldValue *value) {
+	int ret;
+	const char *region = getRegionNo(&ret); //reading manually from dreg
+
+	if (ret < 0) {
+		setError(value, ret, "Could not read vd0:registry/system.dreg", 0);
+		return;
+	}
+	snprintf(value->text, sizeof(value->text), "%s", region);
+}
+
+static void fetchSuspendInterval(SystemSnapshot *snap, FieldValue *value) {
+	fetchRegistryInt(value, "/CONFIG/POWER_SAVING", "suspend_interval", "%i seconds");
+}
+
+static void fetchControllerOffInterval(SystemSnapshot *snap, FieldValue *value) {
+	fetchRegistryInt(value, "/CONFIG/POWER_SAVING", "controller_off_interval", "%i seconds");
+}
+
+// id.dat fields all fail the same way
+static int checkIdDat(SystemSnapshot *snap, FieldValue *value) {
+	if (memoIdDat(snap) < 0) {
+		setError(value, -1, "Error opening ux0:id.dat", 0);
+		return -1;
+	}
+	return 0;
+}
+
+static void fetchPsnNickname(SystemSnapshot *snap, FieldValue *value) {
+	if (checkIdDat(snap, value) == 0)
+		idDatCopy(&id_dat, IDDAT_OID, value->text, sizeof(value->text));
+}
+
+static void fetchPsnEmail(SystemSnapshot *snap, FieldValue *value) {
+	fetchRegistryStr(value, "/CONFIG/NP", "login_id");
+}
+
+static void fetchPsnPassword(SystemSnapshot *snap, FieldValue *value) {
+	fetchRegistryStr(value, "/CONFIG/NP", "password");
+}
+
+static void fetchPSID(SystemSnapshot *snap, FieldValue *value) {
+	if (checkIdDat(snap, value) == 0)
+		idDatCopy(&id_dat, IDDAT_DID, value->text, sizeof(value->text));
+}
+
+static void fetchAccountId(SystemSnapshot *snap, FieldValue *value) {
+	char aid[64];
+	int i, len = 0;
+
+	if (checkIdDat(snap, value) < 0)
+		return;
+	idDatCopy(&id_dat, IDDAT_AID, aid, sizeof(aid));
+
+	///reading and inversing from id.dat
+	for (i = strlen(aid) - 1; i >= 0 && len + 2 < sizeof(value->text); i = i - 2) {
+		if (i > 0)
+			value->text[len++] = aid[i-1];
+		value->text[len++] = aid[i];
+	}
+	value->text[len] = '\0';
+}
+
+static void fetchPsnRegion(SystemSnapshot *snap, FieldValue *value) {
+	fetchRegistryStr(value, "/CONFIG/NP", "country");
+}
+
+/********************* probe table *********************************/
+
+const ProbeDesc probe_table[] = {
+	{ FIELD_MODEL,                   CATEGORY_DEVICE,    GROUP_NET,      "Vita model:",          WHITE,  PROBE_STATIC,   0, NULL,    fetchModel },
+	{ FIELD_FIRMWARE,                CATEGORY_DEVICE,    GROUP_REGISTRY, "Kernel version:",      WHITE,  PROBE_STATIC,   1, NULL,    fetchFirmware },
+	{ FIELD_MAC,                     CATEGORY_DEVICE,    GROUP_NET,      "MAC address:",         WHITE,  PROBE_STATIC,   1, NULL,    fetchMac },
+	{ FIELD_IDPS,                    CATEGORY_DEVICE,    GROUP_POWER,    "IDPS:",                WHITE,  PROBE_STATIC,   1, NULL,    fetchIDPS },
+	{ FIELD_STORAGE,                 CATEGORY_DEVICE,    GROUP_POWER,    "MemoryCard:",          GREY,   PROBE_VOLATILE, 0, NULL,    fetchStorage },
+
+	{ FIELD_ARM_CLOCK,               CATEGORY_PROCESSOR, GROUP_POWER,    "ARM Clock frequency:", YELLOW, PROBE_VOLATILE, 0, NULL,    fetchArmClock },
+	{ FIELD_BUS_CLOCK,               CATEGORY_PROCESSOR, GROUP_POWER,    "BUS Clock frequency:", YELLOW, PROBE_VOLATILE, 0, NULL,    fetchBusClock },
+
+	{ FIELD_BATTERY_PERCENT,         CATEGORY_BATTERY,   GROUP_POWER,    "Battery percentage:",  RED,    PROBE_VOLATILE, 0, isVita,  fetchBatteryPercent },
+	{ FIELD_BATTERY_CAPACITY,        CATEGORY_BATTERY,   GROUP_POWER,    "Battery capacity:",    RED,    PROBE_VOLATILE, 0, isVita,  fetchBatteryCapacity },
+	{ FIELD_BATTERY_STATUS,          CATEGORY_BATTERY,   GROUP_POWER,    "Battery status:",      RED,    PROBE_VOLATILE, 0, isVita,  fetchBatteryStatus },
+	{ FIELD_BATTERY_LIFETIME,        CATEGORY_BATTERY,   GROUP_POWER,    "Battery lifetime:",    RED,    PROBE_VOLATILE, 0, isVita,  fetchBatteryLifetime },
+	{ FIELD_BATTERY_TEMP,            CATEGORY_BATTERY,   GROUP_POWER,    "Battery temperature:", RED,    PROBE_VOLATILE, 0, isVita,  fetchBatteryTemp },
+	{ FIELD_BATTERY_VOLTAGE,         CATEGORY_BATTERY,   GROUP_POWER,    "Battery voltage:",     RED,    PROBE_VOLATILE, 0, isVita,  fetchBatteryVoltage },
+	{ FIELD_BATTERY_SOH,             CATEGORY_BATTERY,   GROUP_POWER,    "State of Health:",     RED,    PROBE_VOLATILE, 0, isVita,  fetchBatterySOH },
+	{ FIELD_BATTERY_DRAIN,           CATEGORY_BATTERY,   GROUP_POWER,    "Drain rate:",          RED,    PROBE_VOLATILE, 0, isVita,  fetchBatteryDrain },
+
+	{ FIELD_BUTTON_ASSIGN,           CATEGORY_REGISTRY,  GROUP_REGISTRY, "button_assign:",       CYAN,   PROBE_STATIC,   0, NULL,    fetchButtonAssign },
+	{ FIELD_LANGUAGE,                CATEGORY_REGISTRY,  GROUP_REGISTRY, "language:",            CYAN,   PROBE_STATIC,   0, NULL,    fetchLanguage },
+	{ FIELD_REGION,                  CATEGORY_REGISTRY,  GROUP_FILES,    "region_no:",           CYAN,   PROBE_STATIC,   0, NULL,    fetchRegion },
+	{ FIELD_SUSPEND_INTERVAL,        CATEGORY_REGISTRY,  GROUP_REGISTRY, "suspend_interval:",    CYAN,   PROBE_STATIC,   0, NULL,    fetchSuspendInterval },
+	{ FIELD_CONTROLLER_OFF_INTERVAL, CATEGORY_REGISTRY,  GROUP_REGISTRY, "contr_off_interval:",  CYAN,   PROBE_STATIC,   0, isDolce, fetchControllerOffInterval },
+
+	{ FIELD_PSN_NICKNAME,            CATEGORY_PSN,       GROUP_FILES,    "PSN Nickname:",        GREEN,  PROBE_STATIC,   0, NULL,    fetchPsnNickname },
+	{ FIELD_PSN_EMAIL,               CATEGORY_PSN,       GROUP_REGISTRY, "E-Mail:",              GREEN,  PROBE_STATIC,   0, NULL,    fetchPsnEmail },
+	{ FIELD_PSN_PASSWORD,            CATEGORY_PSN,       GROUP_REGISTRY, "password:",            GREEN,  PROBE_STATIC,   0, NULL,    fetchPsnPassword },
+	{ FIELD_PSID,                    CATEGORY_PSN,       GROUP_FILES,    "PSID:",                GREEN,  PROBE_STATIC,   0, NULL,    fetchPSID },
+	{ FIELD_ACCOUNT_ID,              CATEGORY_PSN,       GROUP_FILES,    "account_id:",          GREEN,  PROBE_STATIC,   0, NULL,    fetchAccountId },
+	{ FIELD_PSN_REGION,              CATEGORY_PSN,       GROUP_REGISTRY, "region:",              GREEN,  PROBE_STATIC,   0, NULL,    fetchPsnRegion },
+};
+
+const int probe_count = sizeof(probe_table) / sizeof(probe_table[0]);
+
+/********************* collection *********************************/
+
+void snapshotInit(SystemSnapshot *snap) {
+	memset(snap, 0, sizeof(*snap));
+}
+
+int probeVisible(SystemSnapshot *snap, const ProbeDesc *probe) {
+	return probe->visible == NULL || probe->visible(snap);
+}
+
+// every key the registry probes read, in one pass so the probes all hit
+// the cache; values land in the cache, the scratch copy is thrown away
+static void prefetchRegistry(SystemSnapshot *snap, int lane) {
+	char scratch[REG_STRING_SIZE];
+	RegQuery queries[] = {
+		{ "/CONFIG/SYSTEM",       "button_assign",    REG_INT },
+		{ "/CONFIG/SYSTEM",       "language",         REG_INT },
+		{ "/CONFIG/POWER_SAVING", "suspend_interval", REG_INT },
+		{ "/CONFIG/NP",           "login_id",         REG_STRING, 0, 0, scratch, sizeof(scratch) },
+		{ "/CONFIG/NP",           "password",         REG_STRING, 0, 0, scratch, sizeof(scratch) },
+		{ "/CONFIG/NP",           "country",          REG_STRING, 0, 0, scratch, sizeof(scratch) },
+		{ "/CONFIG/POWER_SAVING", "controller_off_interval", REG_INT },	//PSTV only, keep last
+	};
+	int count = sizeof(queries) / sizeof(queries[0]);
+	int span = profileBegin("registry batch", lane);
+
+	if (!isDolce(snap))
+		count--;
+	regGetBatch(queries, count);
+	profileEnd(span);
+}
+
+static void collectGroup(SystemSnapshot *snap, int mask, unsigned categories, int group, int lane) {
+	SceInt64 start = sceKernelGetProcessTimeWide();
+	int i, span, prev_error;
+
+	snap->lane[group] = lane;
+	if (group == GROUP_REGISTRY && (mask & PROBE_STATIC))
+		prefetchRegistry(snap, lane);
+
+	for (i = 0; i < probe_count; i++) {
+		const ProbeDesc *probe = &probe_table[i];
+		FieldValue *value = &snap->fields[probe->id];
+
+		if (probe->group != group || !(probe->volatility & mask) ||
+				!(CATEGORY_BIT(probe->category) & categories) || !probeVisible(snap, probe))
+			continue;
+
+		prev_error = value->error;
+		value->label = NULL;
+		value->error = 0;
+		value->text[0] = '\0';
+		span = profileBegin(probe->label, lane);
+		probe->fetch(snap, value);
+		profileEnd(span);
+		value->collected = 1;
+
+		//queued, workers never wait on the screen; only new failures are
+		//logged so a probe failing on every refresh shows up once
+		if (value->error < 0 && value->error != prev_error)
+			psvDebugScreenLog(RED, "\n! %s/%s %s", group_names[group], field_keys[probe->id], value->text);
+	}
+
+	snap->group_us[group] = sceKernelGetProcessTimeWide() - start;
+}
+
+//the group snapshotCollectBackground is running, if any
+static int busy(SystemSnapshot *snap, int group) {
+	return snap->background > 0 && snap->background_group == group;
+}
+
+void snapshotCollect(SystemSnapshot *snap, int mask, unsigned categories) {
+	SceInt64 start = sceKernelGetProcessTimeWide();
+	int group;
+
+	for (group = 0; group < GROUP_COUNT; group++) {
+		if (!busy(snap, group))
+			collectGroup(snap, mask, categories, group, LANE_MAIN);
+	}
+
+	snap->passes++;
+	snap->collect_us = sceKernelGetProcessTimeWide() - start;
+}
+
+typedef struct {
+	SystemSnapshot *snap;
+	int mask;
+	unsigned categories;
+	int group;
+} CollectJob;
+
+static int collectThread(SceSize args, void *argp) {
+	CollectJob *job = *(CollectJob **)argp;
+
+	collectGroup(job->snap, job->mask, job->categories, job->group, 1 + job->group);
+	return 0;
+}
+
+//facts read from more than one group are fetched up front, so no two
+//workers ever fill the same memo
+static void sharedFacts(SystemSnapshot *snap) {
+	int span = profileBegin("shared facts", LANE_MAIN);
+	memoDolce(snap);
+	memoLanguage(snap);
+	profileEnd(span);
+}
+
+void snapshotCollectParallel(SystemSnapshot *snap, int mask, unsigned categories) {
+	SceInt64 start = sceKernelGetProcessTimeWide();
+	CollectJob jobs[GROUP_COUNT];
+	SceUID threads[GROUP_COUNT];
+	int group;
+
+	sharedFacts(snap);
+
+	for (group = 0; group < GROUP_COUNT; group++) {
+		CollectJob *job = &jobs[group];
+
+		job->snap = snap;
+		job->mask = mask;
+		job->categories = categories;
+		job->group = group;
+		threads[group] = -1;
+		if (busy(snap, group))
+			continue;
+
+		threads[group] = sceKernelCreateThread("psvident_probe", collectThread, 0x10000100, 0x10000, 0, 0, NULL);
+		if (threads[group] >= 0 && sceKernelStartThread(threads[group], sizeof(job), &job) < 0) {
+			sceKernelDeleteThread(threads[group]);
+			threads[group] = -1;
+		}
+	}
+
+	for (group = 0; group < GROUP_COUNT; group++) {
+		if (busy(snap, group))
+			continue;
+		if (threads[group] < 0) {
+			//no worker for this one, run it here instead
+			collectGroup(snap, mask, categories, group, LANE_MAIN);
+			continue;
+		}
+		sceKernelWaitThreadEnd(threads[group], NULL, NULL);
+		sceKernelDeleteThread(threads[group]);
+	}
+
+	snap->passes++;
+	snap->collect_us = sceKernelGetProcessTimeWide() - start;
+}
+
+static CollectJob background_job;
+
+//fields the background job writes, marked or released by the main thread
+static void setPending(SystemSnapshot *snap, int pending) {
+	CollectJob *job = &background_job;
+	int i;
+
+	for (i = 0; i < probe_count; i++) {
+		const ProbeDesc *probe = &probe_table[i];
+
+		if (probe->group == job->group && (probe->volatility & job->mask) &&
+				(CATEGORY_BIT(probe->category) & job->categories) && probeVisible(snap, probe))
+			snap->fields[probe->id].pending = pending;
+	}
+}
+
+void snapshotCollectBackground(SystemSnapshot *snap, int group, int mask, unsigned categories) {
+	CollectJob *job = &background_job;
+	CollectJob *arg = job;
+	SceUID thread;
+
+	if (snap->background > 0)
+		return;
+
+	sharedFacts(snap);
+	job->snap = snap;
+	job->mask = mask;
+	job->categories = categories;
+	job->group = group;
+
+	thread = sceKernelCreateThread("psvident_background", collectThread, 0x10000100, 0x10000, 0, 0, NULL);
+	if (thread < 0) {
+		collectGroup(snap, mask, categories, group, LANE_MAIN);
+		return;
+	}
+
+	setPending(snap, 1);
+	snap->background = thread;
+	snap->background_group = group;
+	if (sceKernelStartThread(thread, sizeof(arg), &arg) < 0) {
+		sceKernelDeleteThread(thread);
+		snap->background = 0;
+		setPending(snap, 0);
+		collectGroup(snap, mask, categories, group, LANE_MAIN);
+	}
+}
+
+int snapshotBackgroundWait(SystemSnapshot *snap, SceUInt timeout_us) {
+	if (snap->background <= 0)
+		return 1;
+	if (sceKernelWaitThreadEnd(snap->background, NULL, &timeout_us) < 0)
+		return 0;
+
+	sceKernelDeleteThread(snap->background);
+	snap->background = 0;
+	setPending(snap, 0);
+	return 1;
+}
+
+int snapshotBackgroundDone(SystemSnapshot *snap) {
+	return snapshotBackgroundWait(snap, 0);
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <psp2/types.h>
+
+#include "graphics.h"
+
+// shown in the title and recorded in exports
+#define PSVIDENT_VERSION "v0.30"
+
+// Everything PSVident reports, collected by a table of probes. Collecting
+// never draws; main.c renders a snapshot after the fact.
+
+typedef enum {
+	CATEGORY_DEVICE,
+	CATEGORY_PROCESSOR,
+	CATEGORY_BATTERY,
+	CATEGORY_REGISTRY,
+	CATEGORY_PSN,
+	CATEGORY_COUNT
+} ProbeCategory;
+
+// sets of categories for collecting, main.c shows one per tab
+#define CATEGORY_BIT(category) (1u << (category))
+#define CATEGORY_ALL ((1u << CATEGORY_COUNT) - 1)
+
+// probes in different groups touch different subsystems and can run on
+// separate threads; a group runs its probes in table order
+typedef enum {
+	GROUP_NET,			// sysmodule loading, MAC
+	GROUP_FILES,		// id.dat, system.dreg
+	GROUP_REGISTRY,		// sceRegMgr
+	GROUP_POWER,		// power, clocks and other kernel queries
+	GROUP_COUNT
+} ProbeGroup;
+
+extern const char *group_names[GROUP_COUNT];
+
+// volatility, also used as the mask for snapshotCollect
+enum {
+	PROBE_STATIC   = 1,	// identity, probed once
+	PROBE_VOLATILE = 2,	// re-polled on every refresh
+	PROBE_ALL      = PROBE_STATIC | PROBE_VOLATILE
+};
+
+typedef enum {
+	FIELD_MODEL,
+	FIELD_FIRMWARE,
+	FIELD_MAC,
+	FIELD_IDPS,
+	FIELD_STORAGE,
+
+	FIELD_ARM_CLOCK,
+	FIELD_BUS_CLOCK,
+
+	FIELD_BATTERY_PERCENT,
+	FIELD_BATTERY_CAPACITY,
+	FIELD_BATTERY_STATUS,
+	FIELD_BATTERY_LIFETIME,
+	FIELD_BATTERY_TEMP,
+	FIELD_BATTERY_VOLTAGE,
+	FIELD_BATTERY_SOH,
+	FIELD_BATTERY_DRAIN,
+
+	FIELD_BUTTON_ASSIGN,
+	FIELD_LANGUAGE,
+	FIELD_REGION,
+	FIELD_SUSPEND_INTERVAL,
+	FIELD_CONTROLLER_OFF_INTERVAL,
+
+	FIELD_PSN_NICKNAME,
+	FIELD_PSN_EMAIL,
+	FIELD_PSN_PASSWORD,
+	FIELD_PSID,
+	FIELD_ACCOUNT_ID,
+	FIELD_PSN_REGION,
+
+	FIELD_COUNT
+} FieldId;
+
+typedef struct {
+	char text[64];		// formatted value, or the reason it failed
+	const char *label;	// overrides the table label when set
+	int error;			// < 0 when the probe failed
+	int collected;		// fetched at least once
+	int pending;		// a background collect owns it, don't read the rest
+} FieldValue;
+
+typedef struct SystemSnapshot SystemSnapshot;
+
+// facts several probes need, each queried once per snapshot
+enum {
+	MEMO_MODEL,
+	MEMO_DOLCE,
+	MEMO_LANGUAGE,
+	MEMO_MAC,
+	MEMO_ID_DAT,
+	MEMO_COUNT
+};
+
+typedef struct {
+	FieldId id;
+	ProbeCategory category;
+	ProbeGroup group;
+	const char *label;
+	Color color;		// bullet color
+	int volatility;
+	int spacing;		// blank lines after the field
+	int (*visible)(SystemSnapshot *snap);	// NULL: always shown
+	void (*fetch)(SystemSnapshot *snap, FieldValue *value);
+} ProbeDesc;
+
+struct SystemSnapshot {
+	// one flag per fact rather than a bitmask, so workers filling different
+	// facts never write the same word
+	unsigned char memo[MEMO_COUNT];
+	int model;
+	int is_dolce;
+	int language;
+	int language_ret;
+	char mac[18];
+	int mac_ret;
+	int net_peak;			// net pool bytes held while reading the MAC
+	int id_dat_ret;
+
+	FieldValue fields[FIELD_COUNT];
+	unsigned passes;
+	SceInt64 collect_us;	// duration of the last pass
+	SceInt64 group_us[GROUP_COUNT];
+	int lane[GROUP_COUNT];	// profiler lane each group last ran on
+
+	SceUID background;		// worker of snapshotCollectBackground, 0 for none
+	int background_group;
+};
+
+// in report order
+extern const ProbeDesc probe_table[];
+extern const int probe_count;
+
+// section and tab titles
+extern const char *category_names[CATEGORY_COUNT];
+
+// names used by the exports
+extern const char *category_keys[CATEGORY_COUNT];
+extern const char *field_keys[FIELD_COUNT];
+
+void snapshotInit(SystemSnapshot *snap);
+
+// runs every visible probe in categories whose volatility is in mask
+void snapshotCollect(SystemSnapshot *snap, int mask, unsigned categories);
+
+// same, with one worker thread per group; returns once all have finished
+void snapshotCollectParallel(SystemSnapshot *snap, int mask, unsigned categories);
+
+// Runs one group's probes on a worker and returns at once, for a group too
+// slow to wait for. Its fields are pending until snapshotBackgroundDone
+// returns 1, and the collects above leave the group alone meanwhile. One at
+// a time; runs the group right away if the worker can't be started.
+void snapshotCollectBackground(SystemSnapshot *snap, int group, int mask, unsigned categories);
+
+// 1 once nothing runs in the background, never blocks
+int snapshotBackgroundDone(SystemSnapshot *snap);
+
+// same, waiting up to timeout_us for the worker to finish
+int snapshotBackgroundWait(SystemSnapshot *snap, SceUInt timeout_us);
+
+int probeVisible(SystemSnapshot *snap, const ProbeDesc *probe);
@@ -0,0 +1,379 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <psp2/power.h>
+#include <psp2/net/net.h>
+#include <psp2/sysmodule.h>
+
+#include "fmt.h"
+#include "sysinfo.h"
+
+//! id.dat, read once; the values point into id_dat_buffer
+static char id_dat_buffer[IDDAT_MAX_SIZE];
+IdDat id_dat;
+
+//! Console CID/IDPS
+int _vshSblAimgrGetConsoleId(char CID[16]);
+
+void getCID(char *cid_string) {
+	
+	char CID[16];
+	
+	_vshSblAimgrGetConsoleId(CID);
+
+	fmtHexBytes(cid_string, (unsigned char *)CID, 16);
+}
+
+//! clock freq
+int getClockFrequency(int no){
+	if (no == 0) return scePowerGetArmClockFrequency();
+	else if (no == 1)	return scePowerGetBusClockFrequency();
+	else if (no == 2)	return scePowerGetGpuClockFrequency();
+	else return 0;
+}
+	
+const char* getMode() {
+	int cex = vshSblAimgrIsCEX();	
+	int dex = vshSblAimgrIsDEX();
+	//int test = vshSblAimgrIsTest(); /*testkits will show as DEX :/ */
+	int tool = vshSblAimgrIsTool();
+	
+	int idu = vshSysconIsIduMode();
+	int show = vshSysconIsShowMode();
+	
+	//version spoofing side effect fix here
+	if ( cex == dex ) {
+		int ret = 0;
+
+		getInteger("/CONFIG/SYSTEM", "debug_mode", &ret); //test&dex-registry only
+		//ret = sceRegMgrGetKeyInt("/DEVENV/TOOL/", "machine_type", &val); //tool-registry only
+	
+		if (ret < 0) {
+			if ( idu ) {
+				return "CEX (IDU)";
+			} else {
+				return "CEX";
+			}
+		}	
+		return "Test/Dev Kit";
+	}
+
+	
+	//Normal detection
+	if ( cex ) {
+		if ( idu ) {
+			return "CEX (IDU)";
+		} else {
+			return "CEX";
+		}
+	/*} else if ( test ) {
+		if ( show ) {
+			return "Testing Kit (Show Mode)";
+		} else {
+			return "Testing Kit";
+		}*/
+	} else if ( dex ) {
+		if ( show ) {
+			return "Test/Dev Kit (Show Mode)";
+		} else {
+			return "Test/Dev Kit";
+		}
+	} else if ( tool ) {
+		return "Tool";
+	} else {
+		return "error";
+	}
+}
+
+/********************* converting functions *********************************/
+
+const char* convert_button_assign(int button_assign) {
+	switch ( button_assign ) {
+		case 0: return "O = Enter";
+		case 1: return "X = Enter";
+		default: return "Unknown layout!?";
+	}
+}
+
+const char* convert_language(int language) {
+	switch ( language ) {
+		case 0: return "Japanese";
+		case 1: return "English US";
+		case 2: return "French";
+		case 3: return "Spanish";
+		case 4: return "German";
+		case 5: return "Italian";
+		case 6: return "Dutch"; 
+		case 7: return "Portuguese";
+		case 8: return "Russian"; 
+		case 9: return "Korean"; 
+		case 10: return "Traditional Chinese";
+		case 11: return "Simplified Chinese";
+		case 12: return "Finnish";
+		case 13: return "Swedish"; 
+		case 14: return "Danish";
+		case 15: return "Norwegian";
+		case 16: return "Polish";
+		case 17: return "Brazilian Portuguese";
+		case 18: return "English UK";
+		default: return "Unknown layout!?";
+	}
+}
+
+const char* convert_model(int model, const char *mac_string) {
+	char fat_string[] = "D4:4B:5E";
+	
+	switch ( model ) {
+		case 65536: //0x10000
+			//Fat or Slim by MAC Address until theres a better solution
+			if(strstr(mac_string, fat_string)) {
+				return "Vita Fat";
+			} else {
+				return "Vita Slim";
+			}
+		case 131072: return "PlayStation TV"; //0x20000
+		default: return "Unknown model!?";
+	}
+}
+
+
+
+/****************************** custom string functions ****************************************/
+char* stringReplace(char *search, char *replace, char *string) {
+	char *tempString, *searchStart;
+	int len=0;
+
+	searchStart = strstr(string, search);
+	if(searchStart == NULL) {
+		return string;
+	}
+
+	tempString = (char*) malloc((strlen(string) + 1) * sizeof(char));
+	if(tempString == NULL) {
+		return NULL;
+	}
+
+	strcpy(tempString, string);
+
+	len = searchStart - string;
+	string[len] = '\0';
+
+	strcat(string, replace);
+
+	len += strlen(search);
+	strcat(string, (char*)tempString+len);
+
+	free(tempString);
+	
+	return string;
+}
+
+//thx TheFloW!
+void getSizeString(char *string, uint64_t size) {
+	fmtSize(string, size);
+}
+
+
+/****************************** Registry functions ****************************************/
+
+///type02 - int
+int getInteger(const char* location, const char* value, int *ret) {
+	RegQuery query = { location, value, REG_INT };
+	
+	regGetBatch(&query, 1);
+	*ret = query.error;
+	return query.value;
+}
+
+///type03 - string
+int getString(const char* reg, const char* key, char *string, int size) {
+	RegQuery query = { reg, key, REG_STRING };
+	
+	query.string = string;
+	query.size = size;
+	regGetBatch(&query, 1);
+	return query.error;
+}
+
+
+//! system.dreg, read once on first use
+static void *dreg_buffer = NULL;
+static Dreg dreg;
+static int dreg_ret = 1;	//not read yet
+
+const Dreg* getDreg(int *ret) {
+	FILE *fp;
+	long size;
+
+	if (dreg_ret > 0) {
+		fp = fopen(DREG_PATH, "rb");
+		if (fp == NULL) {
+			dreg_ret = -1;
+		} else {
+			fseek(fp, 0, SEEK_END);
+			size = ftell(fp);
+			fseek(fp, 0, SEEK_SET);
+
+			dreg_buffer = malloc(size > 0 ? size : 1);
+			if (dreg_buffer == NULL || fread(dreg_buffer, 1, size, fp) != size) {
+				dreg_ret = -1;
+			} else {
+				dregInit(&dreg, dreg_buffer, size);
+				dreg_ret = 0;
+			}
+			fclose(fp);
+		}
+	}
+
+	*ret = dreg_ret;
+	return dreg_ret < 0 ? NULL : &dreg;
+}
+
+///region_no, straight from system.dreg :/
+const char* getRegionNo(int *ret) {
+	const Dreg *dreg = getDreg(ret);
+	int region = 0;
+
+	if (dreg == NULL)
+		return ""; //Could not open vd0:registry/system.dreg
+	*ret = dregGetInt(dreg, "/CONFIG/SYSTEM", "region_no", &region);
+	if (*ret < 0)
+		return "";
+
+	switch ( region ) {
+		case 0: return "0";
+		case 1: return "Japan";				//PCH-X000
+		case 2: return "North America"; 	//PCH-X001
+		case 3: return "Australia";			//PCH-x002 
+		case 4: return "United Kingdom"; 	//PCH-x003
+		case 5: return "Europe"; 			//PCH-X004
+		case 6: return "Korea";				//
+		case 7: return "Asia"; 				//
+		case 8: return "Taiwan";			//
+		case 9: return "Russia"; 			//PCH-X008
+		case 10: return "Mexico"; 			//
+		case 11: return "msg_off"; 		
+		case 12: return "12"; 
+		case 13: return "China"; 			//
+		case 14: return "14"; 
+		case 15: return "15"; 
+		default: return "Unknown layout!?";
+	}
+}
+
+
+/******************** Battery functions **********************************/
+
+const char* getBatteryStatus() {
+    if (!scePowerIsBatteryCharging()) return "In use";
+    else return "Charging";
+}
+
+int getBatteryRemCapacity(){
+	return scePowerGetBatteryRemainCapacity();
+}
+int getBatteryCapacity(){
+	return scePowerGetBatteryFullCapacity();
+}
+
+void getBatteryPercentage(char *percentage) {
+	int len = fmtInt(percentage, scePowerGetBatteryLifePercent());
+	percentage[len++] = '%';
+	percentage[len] = '\0';
+}
+
+///mV
+void getBatteryVoltage(char *voltage) {
+	fmtFixed(voltage, scePowerGetBatteryVolt(), 3, 2);
+}
+
+///1/100 degree Celsius
+void getBatteryTempInCelsius(char *temp) {
+	fmtFixed(temp, scePowerGetBatteryTemp(), 2, 2);
+}
+void getBatteryTempInFahrenheit(char *temp) {
+	//in 1/1000 degree, so the * 1.8 stays exact
+	fmtFixed(temp, scePowerGetBatteryTemp() * 18 + 32000, 3, 2);
+}
+
+/********************* MAC address *********************************/
+
+//the net stack is only brought up for this one read: the pool is freed and
+//the module unloaded again before returning
+static int readMacWithPool(SceNetEtherAddr *mac, int size) {
+	SceNetInitParam initparam;
+	void *memory;
+	int ret, owned;
+
+	memory = malloc(size);
+	if (memory == NULL)
+		return -1;
+
+	initparam.memory = memory;
+	initparam.size = size;
+	initparam.flags = 0;
+
+	ret = sceNetInit(&initparam);
+	owned = ret >= 0;
+	if (ret < 0 && ret != NET_ERROR_EBUSY) {
+		free(memory);
+		return ret;
+	}
+
+	ret = sceNetGetMacAddress(mac, 0);
+
+	//someone else's net stack stays up
+	if (owned)
+		sceNetTerm();
+	free(memory);
+	return ret;
+}
+
+int getMac(char *mac_string, int *peak) {
+	SceNetEtherAddr mac;
+	int ret, loaded = 0;
+
+	mac_string[0] = '\0';
+	*peak = 0;
+
+	if (sceSysmoduleIsLoaded(SCE_SYSMODULE_NET) != SCE_SYSMODULE_LOADED) {
+		ret = sceSysmoduleLoadModule(SCE_SYSMODULE_NET);
+		if (ret < 0)
+			return ret;
+		loaded = 1;
+	}
+
+	*peak = NET_POOL_SIZE;
+	ret = readMacWithPool(&mac, NET_POOL_SIZE);
+	if (ret < 0) {
+		//firmware that wants the old pool size
+		*peak = NET_POOL_FALLBACK_SIZE;
+		ret = readMacWithPool(&mac, NET_POOL_FALLBACK_SIZE);
+	}
+
+	if (loaded)
+		sceSysmoduleUnloadModule(SCE_SYSMODULE_NET);
+
+	if (ret < 0)
+		return ret;
+
+	fmtMac(mac_string, mac.data);
+	return 0;
+}
+
+
+
+/********************* id.dat *********************************/
+int readIDDAT() {	
+	FILE* f1 = fopen("ux0:id.dat", "rb");
+	int size;
+	
+	if (f1 == NULL){
+		return -1; //Error opening ux0:id.dat
+	}
+	size = fread(id_dat_buffer, 1, sizeof(id_dat_buffer), f1);
+	fclose(f1);
+	
+	return idDatParse(&id_dat, id_dat_buffer, size);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stdint.h>
+#include <psp2/types.h>
+
+#include "dreg.h"
+#include "iddat.h"
+#include "registry.h"
+
+#define NET_POOL_SIZE (64 * 1024)				//enough for sceNetGetMacAddress
+#define NET_POOL_FALLBACK_SIZE (1 * 1024 * 1024)	//what initnet() used to keep resident
+#define NET_ERROR_EBUSY 0x80410110
+
+//! System Version
+typedef struct {
+	SceUInt size;
+	SceChar8 version_string[28];
+	SceUInt version_value;
+	SceUInt unk;
+} SceSystemSwVersionParam;
+int sceKernelGetSystemSwVersion(SceSystemSwVersionParam *param);
+
+//! Battery
+int scePowerIsBatteryExist();
+int scePowerGetBatteryTemp();
+int scePowerGetBatteryVolt();
+int scePowerGetBatterySOH();
+
+//! Vita model
+int sceKernelGetModelForCDialog();
+
+//! Memory Card checks
+int vshMemoryCardGetCardInsertState();
+int vshRemovableMemoryGetCardInsertState();
+
+//! CEX, DEX, Test, IDU
+int vshSblAimgrIsCEX();				//retail
+int vshSblAimgrIsDEX();
+int vshSblAimgrIsDolce();			//PSTV
+int vshSblAimgrIsGenuineDolce();	//PSTV
+int vshSblAimgrIsGenuineVITA();		//Vita Fat&Slim
+int vshSblAimgrIsTest();
+int vshSblAimgrIsTool();
+int vshSblAimgrIsVITA();			//Vita Fat&Slim
+int vshSysconIsIduMode();			//is IDU device (not is in DEMO MODE currently!)
+int vshSysconIsShowMode();			//is in Show Mode
+
+//! id.dat, filled by readIDDAT()
+extern IdDat id_dat;
+
+// All of these write into caller buffers, so two results can be used in the
+// same printf. Functions returning int report SCE errors as negative values.
+
+//! Console CID/IDPS, 33 bytes
+void getCID(char *cid_string);
+
+//! clock freq
+int getClockFrequency(int no);
+
+const char* getMode();
+
+//! converting functions
+const char* convert_button_assign(int button_assign);
+const char* convert_language(int language);
+const char* convert_model(int model, const char *mac_string);
+
+char* stringReplace(char *search, char *replace, char *string);
+
+//thx TheFloW!
+void getSizeString(char *string, uint64_t size);
+
+//! Registry, cached (see registry.h); *ret gets the sceRegMgr result
+int getInteger(const char* location, const char* value, int *ret);
+int getString(const char* reg, const char* key, char *string, int size);
+
+//! vd0:registry/system.dreg, read into memory on the first call
+const Dreg* getDreg(int *ret);
+
+//! region_no from system.dreg, *ret < 0 if it can't be read
+const char* getRegionNo(int *ret);
+
+//! Battery
+const char* getBatteryStatus();
+int getBatteryRemCapacity();
+int getBatteryCapacity();
+void getBatteryPercentage(char *percentage);		//16 bytes
+void getBatteryVoltage(char *voltage);				//24 bytes
+void getBatteryTempInCelsius(char *temp);			//24 bytes
+void getBatteryTempInFahrenheit(char *temp);		//24 bytes
+
+//! MAC address, 18 bytes. Loads the NET module and a net pool just for the
+//! read and releases both before returning; *peak gets the pool size used
+int getMac(char *mac_string, int *peak);
+
+//! id.dat, returns < 0 if it couldn't be opened, 1 if lines were malformed
+int readIDDAT();